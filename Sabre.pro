@@ -14,32 +14,60 @@ TEMPLATE = app
 
 SOURCES += main.cpp\
     parse.cpp \
+    parse_context.cpp \
+    parse_event.cpp \
+    parse_loader.cpp \
+    parse_pipeline.cpp \
+    parse_reader.cpp \
+    parse_scan.cpp \
+    parse_worker.cpp \
     sabre_output.cpp \
     ui_databasedlg.cpp \
     ui_mainwindow.cpp \
     sabre_search.cpp \
+    sabre_bench.cpp \
     bb_ballpark.cpp \
     bb_defs.cpp \
     bb_game.cpp \
+    bb_manifest.cpp \
+    bb_play.cpp \
     bb_player.cpp \
     bb_record.cpp \
+    bb_snapshot.cpp \
     bb_stat.cpp \
+    bb_statlog.cpp \
+    bb_stattable.cpp \
     bb_team.cpp \
     bb_state.cpp
 
 HEADERS  += \
     parse.h \
+    parse_context.h \
+    parse_event.h \
+    parse_loader.h \
+    parse_pipeline.h \
+    parse_reader.h \
+    parse_scan.h \
+    parse_stage.h \
+    parse_worker.h \
     baseball.h \
     sabre_output.h \
     ui_databasedlg.h \
     ui_mainwindow.h \
     sabre_search.h \
+    sabre_bench.h \
     sabre.h \
     bb_ballpark.h \
     bb_defs.h \
     bb_game.h \
+    bb_manifest.h \
+    bb_play.h \
     bb_player.h \
     bb_record.h \
+    bb_smallvector.h \
+    bb_snapshot.h \
     bb_stat.h \
+    bb_statlog.h \
+    bb_stattable.h \
     bb_state.h \
     bb_team.h
@@ -24,6 +24,7 @@
 #include "bb_defs.h"
 #include "bb_record.h"
 #include "bb_state.h"
+#include "bb_statlog.h"
 
 // record/table types
 #include "bb_player.h"
@@ -31,4 +32,11 @@
 #include "bb_ballpark.h"
 #include "bb_team.h"
 
+// source files
+#include "bb_manifest.h"
+
+// analysis
+#include "bb_play.h"
+#include "bb_stattable.h"
+
 #endif // BASEBALL_H
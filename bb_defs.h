@@ -19,11 +19,16 @@
  */
 #pragma once
 
+#include "bb_smallvector.h"
+
 #include <string>
 #include <list>
 #include <map>
 #include <set>
 #include <assert.h>
+#include <ctype.h>
+
+#include <QAtomicPointer>
 
 #define TAGLEN  13
 
@@ -33,14 +38,6 @@
 
 typedef unsigned int uint;
 
-static bool tag_cmp(const char *ref1, const char *ref2)
-{
-    for (int i = 0; i < TAGLEN; i++) {
-        if (ref1[i] != ref2[i]) return false;
-    }
-    return true;
-}
-
 static void tag_cpy(char *ref_to, const char *ref_from)
 {
     memset(ref_to, ' ', TAGLEN);
@@ -148,6 +145,47 @@ namespace Baseball {
 
 	typedef std::string commment;
 
+    // The characters of a tag, case folded and packed into integers so tags
+    // can be compared without looping over their characters.  The first
+    // eight characters (all of a player, team or ballpark id) are packed
+    // big endian into head and the next four into tail, so comparing
+    // (head, tail) orders tags the same way as comparing folded characters.
+    struct tag_key
+    {
+        unsigned long long head;
+        unsigned int tail;
+
+        bool operator<(const tag_key& rhs) const {
+            return ((head < rhs.head) ||
+                    ((head == rhs.head) && (tail < rhs.tail)));
+        }
+        bool operator==(const tag_key& rhs) const {
+            return ((head == rhs.head) && (tail == rhs.tail));
+        }
+        bool operator!=(const tag_key& rhs) const {
+            return (false == operator==(rhs));
+        }
+    };
+
+    // packs the first TAGLEN - 1 characters of ref
+    inline tag_key tag_pack(const char* ref)
+    {
+        tag_key k;
+
+        k.head = 0;
+        k.tail = 0;
+
+        for (int i = 0; i < 8; i++) {
+            k.head = ((k.head << 8) | static_cast<unsigned char>(tolower(static_cast<unsigned char>(ref[i]))));
+        }
+
+        for (int i = 8; i < (TAGLEN - 1); i++) {
+            k.tail = ((k.tail << 8) | static_cast<unsigned char>(tolower(static_cast<unsigned char>(ref[i]))));
+        }
+
+        return k;
+    }
+
     class tag {
     public:
 		enum {
@@ -164,12 +202,22 @@ namespace Baseball {
 
         char ref[TAGLEN];
 
-        tag() : type(Unknown) {}
+        // ref packed for comparison, kept in step with ref by set
+        tag_key key;
+
+        tag() : type(Unknown) { set("", 0); }
+
+        // copies len characters of r into the tag
+        void set(const char* r, size_t len) {
+            tag_cpy_s(ref, r, len);
+            key = tag_pack(ref);
+        }
 
 		tag& operator=(const tag& rhs) {
 			if (this != &rhs) {
 				type = rhs.type;
 				tag_cpy(ref, rhs.ref);
+				key = rhs.key;
 			}
 
 			return *this;
@@ -188,19 +236,15 @@ namespace Baseball {
             if (type < rhs.type) { return true; }
             else if (type > rhs.type) { return false; }
             else {
-                int i = 0;
-                while ((i < (TAGLEN - 1)) &&
-                       (tolower(ref[i]) == tolower(rhs.ref[i])))
-                {
-                    i++;
-                }
-                return (tolower(ref[i]) < tolower(rhs.ref[i]));
+                return (key < rhs.key);
             }
         }
 
+        // tags compare equal if their characters are equal ignoring case,
+        // the same equivalence used by operator< and the record tables
 		bool operator==(const tag& rhs) const {
 			return ((type == rhs.type) &&
-					(tag_cmp(ref, rhs.ref)));
+					(key == rhs.key));
 		}
 
 		bool operator!=(const tag& rhs) const {
@@ -213,7 +257,7 @@ namespace Baseball {
         player_tag() { type = Player; }
         player_tag(const std::string& r) {
             type = Player;
-            tag_cpy_s(ref, r.c_str(), r.length());
+            set(r.c_str(), r.length());
         }
     };
 
@@ -222,7 +266,7 @@ namespace Baseball {
         umpire_tag() { type = Umpire; }
         umpire_tag(const std::string& r) {
             type = Umpire;
-            tag_cpy_s(ref, r.c_str(), r.length());
+            set(r.c_str(), r.length());
         }
     };
 
@@ -231,7 +275,7 @@ namespace Baseball {
         manager_tag() { type = Manager; }
         manager_tag(const std::string& r) {
             type = Manager;
-            tag_cpy_s(ref, r.c_str(), r.length());
+            set(r.c_str(), r.length());
         }
     };
 
@@ -240,7 +284,7 @@ namespace Baseball {
         team_tag() { type = Team; }
         team_tag(const std::string& r) {
             type = Team;
-            tag_cpy_s(ref, r.c_str(), r.length());
+            set(r.c_str(), r.length());
         }
     };
 
@@ -249,7 +293,7 @@ namespace Baseball {
         game_tag() { type = Game; }
         game_tag(const std::string& r) {
             type = Game;
-            tag_cpy_s(ref, r.c_str(), r.length());
+            set(r.c_str(), r.length());
         }
     };
 
@@ -258,7 +302,7 @@ namespace Baseball {
         season_tag() { type = Season; }
         season_tag(const std::string& r) {
             type = Season;
-            tag_cpy_s(ref, r.c_str(), r.length());
+            set(r.c_str(), r.length());
         }
     };
 
@@ -267,7 +311,7 @@ namespace Baseball {
         ballpark_tag() { type = BallPark; }
         ballpark_tag(const std::string& r) {
             type = BallPark;
-            tag_cpy_s(ref, r.c_str(), r.length());
+            set(r.c_str(), r.length());
         }
     };
 
@@ -300,7 +344,9 @@ namespace Baseball {
         }
     };
 
-    typedef std::list<PositionRef> PositionRefList;
+    // used for the runners on base and the assists on an out.  Two covers
+    // nearly every out, more assists or runners spill to the heap.
+    typedef SmallVector<PositionRef, 2> PositionRefList;
 
 	class Pitch
 	{
@@ -378,7 +424,95 @@ namespace Baseball {
             blocked(b) {}
 	};
 
-    typedef std::list<Pitch> Pitches;
+    // The pitches of a play packed one byte per pitch, in the order they
+    // were thrown.  The low five bits of a byte hold the pitch type, or the
+    // pickoff for a pickoff throw, which has no pitch type.  Short sequences
+    // fit in the string's own buffer, so most plays need no allocation.
+    class Pitches
+    {
+    public:
+        enum {
+            TYPE_MASK    = 0x1f,
+            PICKOFF      = 0x20,
+            BLOCKED      = 0x40,
+            RUNNER_GOING = 0x80
+        };
+
+        static unsigned char pack(const Pitch& p)
+        {
+            unsigned char b = ((p.pickoff != Pitch::NoPickoff) ?
+                               (PICKOFF | static_cast<unsigned char>(p.pickoff)) :
+                               static_cast<unsigned char>(p.type));
+
+            if (p.blocked) b |= BLOCKED;
+            if (p.runnerGoing) b |= RUNNER_GOING;
+
+            return b;
+        }
+
+        static Pitch unpack(unsigned char b)
+        {
+            Pitch p;
+
+            if (b & PICKOFF) {
+                p.pickoff = static_cast<Pitch::PickOff>(b & TYPE_MASK);
+            } else {
+                p.type = static_cast<Pitch::Type>(b & TYPE_MASK);
+            }
+
+            p.blocked = ((b & BLOCKED) != 0);
+            p.runnerGoing = ((b & RUNNER_GOING) != 0);
+
+            return p;
+        }
+
+        class const_iterator
+        {
+        public:
+            const_iterator(const unsigned char* b = NULL) : m_byte(b) {}
+
+            Pitch operator*() const { return unpack(*m_byte); }
+
+            const_iterator& operator++() { m_byte++; return *this; }
+            const_iterator operator++(int) { const_iterator it(*this); m_byte++; return it; }
+
+            bool operator==(const const_iterator& rhs) const { return (m_byte == rhs.m_byte); }
+            bool operator!=(const const_iterator& rhs) const { return (m_byte != rhs.m_byte); }
+
+        private:
+            const unsigned char* m_byte;
+        };
+
+    public:
+        void clear() { m_bytes.clear(); }
+        void push_back(const Pitch& p) { m_bytes.push_back(static_cast<char>(pack(p))); }
+        void push_back(unsigned char b) { m_bytes.push_back(static_cast<char>(b)); }
+
+        size_t size() const { return m_bytes.size(); }
+        bool empty() const { return m_bytes.empty(); }
+
+        Pitch at(size_t i) const { return unpack(data()[i]); }
+
+        // makes room for n packed bytes and returns them, so that they can
+        // be filled in one read
+        unsigned char* resize(size_t n)
+        {
+            m_bytes.resize(n);
+            return reinterpret_cast<unsigned char*>(&m_bytes[0]);
+        }
+
+        // the packed bytes, for scanning many plays without unpacking
+        const unsigned char* data() const
+        {
+            return reinterpret_cast<const unsigned char*>(m_bytes.data());
+        }
+
+        const_iterator begin() const { return const_iterator(data()); }
+        const_iterator end() const { return const_iterator(data() + m_bytes.size()); }
+
+    private:
+        std::string m_bytes;
+    };
 
     // class representing information about batted balls in play
     class BattedBall
@@ -447,7 +581,8 @@ namespace Baseball {
         Base m_adv[4];
     };
 
-    typedef std::list<Advance> Advances;
+    // one for the batter and each runner
+    typedef SmallVector<Advance, 4> Advances;
 
     // out
     // each out denotes a single out and the assist(s) for that out.  A double
@@ -498,7 +633,9 @@ namespace Baseball {
         }
     };
 
-    typedef std::list<Out> Outs;
+    // a play makes at most three outs, but a triple play is rare enough that
+    // it is left to spill to the heap rather than grow every state
+    typedef SmallVector<Out, 2> Outs;
 
     /*
      * Reconstructing Plays from state & event data
@@ -564,25 +701,37 @@ namespace Baseball {
         return (obj != static_cast<T*>(0));
     }
 
+    // The instance is created on first use.  Threads racing to create it
+    // each build one, and all but the first to be published are thrown
+    // away, so T should not have side effects on construction.
     template<typename T>
     class Singleton
     {
     public:
         static T* getInstance() {
-            if (!isValid(m_instance)) {
-                m_instance = new (std::nothrow) T;
+            T* t = m_instance.loadAcquire();
+
+            if (!isValid(t)) {
+                T* created = new (std::nothrow) T;
+
+                if (m_instance.testAndSetOrdered(static_cast<T*>(0), created)) {
+                    t = created;
+                } else {
+                    delete created;
+                    t = m_instance.loadAcquire();
+                }
             }
 
-            assert(m_instance);
+            assert(t);
 
-            return m_instance;
+            return t;
         }
     private:
-        static T* m_instance;
+        static QAtomicPointer<T> m_instance;
     };
 
     template<typename T>
-    T* Singleton<T>::m_instance = static_cast<T*>(0);
+    QAtomicPointer<T> Singleton<T>::m_instance;
 
     template<typename K, typename V>
     std::list<K> keys(const std::map<K, V> &m)
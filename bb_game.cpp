@@ -19,6 +19,8 @@
  */
 #include "bb_game.h"
 
+#include <algorithm>
+
 namespace Baseball {
     namespace Game {
 
@@ -99,6 +101,16 @@ namespace Baseball {
 
         ///////////////////////////////////////////////////////////////////////
 
+        const quint16 Lineup::NO_ENTRY = 0xffff;
+
+
+        Lineup::Lineup()
+        {
+            std::fill(&m_order[0][0], &m_order[0][0] + (2 * MAX_ORDER), NO_ENTRY);
+            std::fill(&m_position[0][0], &m_position[0][0] + (2 * MAX_POSITION), NO_ENTRY);
+        }
+
+
         bool Lineup::sub(
             const player_tag& pt,
             const Instance& inst,
@@ -106,41 +118,68 @@ namespace Baseball {
             const uint order,
             bool visitor)
         {
-            bool ret = false;
-            LineupList::iterator it = m_lineup.find(pt);
-            Card c;
+            bool ret = true;
+            size_t i = 0;
+            Entry e;
+
+            for (; i < m_players.size(); i++) {
+                if (m_players[i].key == pt.key) {
+                    ret = false;
+                    break;
+                }
+            }
 
-            c.order = order;
-            c.visiting = visitor;
-            c.position = p;
-            c.instance = inst;
-
-            if (it == m_lineup.end()) {
-//                it = findOrder(order, visitor);
-                std::pair<LineupList::iterator, bool> r = m_lineup.insert(std::make_pair(pt, c));
-
-                ret = r.second;
-            } else {
-                // TODO:
-                // we'll ultimately need to find a better way to do this without
-                // trashing our previous data
-                it->second.order = order;
-                it->second.position = p;
+            if (ret) {
+                m_players.push_back(pt);
+                m_current.push_back(NO_ENTRY);
             }
 
+            e.instance = inst;
+            e.player = static_cast<quint16>(i);
+            e.previousPosition = NO_ENTRY;
+            e.previousOrder = NO_ENTRY;
+            e.position = static_cast<quint8>(p);
+            e.order = static_cast<quint8>(order);
+            e.visiting = visitor;
+
+            quint16 index = static_cast<quint16>(m_history.size());
+            int side = visitor ? 1 : 0;
+
+            if (static_cast<uint>(p) < MAX_POSITION) {
+                e.previousPosition = m_position[side][p];
+                m_position[side][p] = index;
+            }
+
+            if (order < MAX_ORDER) {
+                e.previousOrder = m_order[side][order];
+                m_order[side][order] = index;
+            }
+
+            m_current[i] = index;
+            m_history.push_back(e);
+
             return ret;
         }
 
 
         Lineup::Card Lineup::card(const player_tag& t) const
         {
-            LineupList::const_iterator it = m_lineup.find(t);
             Card c;
 
-            memset(&c, 0, sizeof(Card));
+            c.position = NoPosition;
+            c.order = 0;
+            c.visiting = false;
+
+            for (size_t i = 0; i < m_players.size(); i++) {
+                if (m_players[i].key == t.key) {
+                    const Entry& e = m_history[m_current[i]];
 
-            if (it != m_lineup.end()) {
-                c = it->second;
+                    c.position = static_cast<Position>(e.position);
+                    c.order = e.order;
+                    c.instance = e.instance;
+                    c.visiting = e.visiting;
+                    break;
+                }
             }
 
             return c;
@@ -149,14 +188,10 @@ namespace Baseball {
 
         player_tag Lineup::find(const Instance& inst) const
         {
-            LineupList::const_iterator it = m_lineup.begin();
-
-            while (it != m_lineup.end()) {
-                if (it->second.instance == inst) {
-                    return it->first;
+            for (size_t i = 0; i < m_history.size(); i++) {
+                if (m_history[i].instance == inst) {
+                    return m_players[m_history[i].player];
                 }
-
-                it++;
             }
 
             return player_tag();
@@ -167,52 +202,11 @@ namespace Baseball {
                                 bool visitor,
                                 const Instance& after) const
         {
-            LineupList::const_iterator it = m_lineup.begin();
-            LineupList::const_iterator best = m_lineup.end();
-
-            while (it != m_lineup.end()) {
-                Card c = it->second;
-
-                // is this a match?
-                if ((c.position == p) &&
-                    (c.visiting == visitor)) {
-                    // is this the first match?
-                    if (best == m_lineup.end()) {
-                        best = it;
-                    // otherwise see if this match is better
-                    } else {
-                        // if this iterator's instance less than after
-                        if (c.instance < after) {
-                            // this player was subbed in before after, if they
-                            // were subbed in after the current best, they are
-                            // the new best
-                            if (c.instance > best->second.instance) {
-                                best = it;
-                            }
-                        } else if (c.instance > after) {
-                            // this player was subbed in after after, if they
-                            // were subbed in before the current best, they are
-                            // the new best
-                            if (c.instance < best->second.instance) {
-                                best = it;
-                            }
-                        } else {
-                            // this player was subbed in exactly at after, this
-                            // player is the new best only if the current best
-                            // doesn't share the same instance.
-                            if (c.instance != best->second.instance) {
-                                best = it;
-                            }
-                        }
-                    }
-                }
-
-                it++;
-            }
-
-            if (best == m_lineup.end()) return player_tag();
+            if (static_cast<uint>(p) >= MAX_POSITION) return player_tag();
 
-            return best->first;
+            return latest(m_position[visitor ? 1 : 0][p],
+                          &Entry::previousPosition,
+                          after);
         }
 
 
@@ -220,57 +214,138 @@ namespace Baseball {
                                 bool visitor,
                                 const Instance& after) const
         {
-            LineupList::const_iterator it = m_lineup.begin();
-            LineupList::const_iterator best = m_lineup.end();
-
-            while (it != m_lineup.end()) {
-                Card c = it->second;
-
-                // is this a match?
-                if ((c.order == order) &&
-                    (c.visiting == visitor)) {
-                    if (best == m_lineup.end()) {
-                        best = it;
-                    } else {
-                        if (c.instance < after) {
-                            if (c.instance > best->second.instance) {
-                                best = it;
-                            }
-                        } else if (c.instance > after) {
-                            if (c.instance < best->second.instance) {
-                                best = it;
-                            }
-                        } else {
-                            if (c.instance != best->second.instance) {
-                                best = it;
-                            }
-                        }
-                    }
-                }
+            if (order >= MAX_ORDER) return player_tag();
+
+            return latest(m_order[visitor ? 1 : 0][order],
+                          &Entry::previousOrder,
+                          after);
+        }
+
+
+        player_tag Lineup::latest(quint16 e,
+                                  quint16 Entry::*previous,
+                                  const Instance& after) const
+        {
+            if (e == NO_ENTRY) return player_tag();
+
+            // plays are parsed in order, so the latest entry is almost always
+            // the one wanted
+            while ((m_history[e].instance > after) &&
+                   (m_history[e].*previous != NO_ENTRY)) {
+                e = m_history[e].*previous;
+            }
+
+            return m_players[m_history[e].player];
+        }
+
+
+        ///////////////////////////////////////////////////////////////////////
+
+        Cache::Cache() :
+            m_loader(NULL),
+            m_capacity(DEFAULT_CAPACITY)
+        {
 
-                it++;
+        }
+
+
+        Cache::~Cache()
+        {
+            delete m_loader;
+        }
+
+
+        void Cache::setLoader(Loader* l)
+        {
+            Cache* c = getInstance();
+
+            if (c->m_loader != l) {
+                delete c->m_loader;
+                c->m_loader = l;
+            }
+        }
+
+
+        void Cache::setCapacity(size_t n)
+        {
+            Cache* c = getInstance();
+
+            c->m_capacity = std::max<size_t>(1, n);
+
+            while (c->m_order.size() > c->m_capacity) {
+                c->evict();
+            }
+        }
+
+
+        StateLink Cache::plays(Record* r)
+        {
+            if (!r) return NULL;
+
+            // games parsed up front are always loaded
+            if (!r->source.isValid()) return r->plays;
+
+            Cache* c = getInstance();
+            Entries::iterator it = c->m_entries.find(r->id().key);
+
+            if (it != c->m_entries.end()) {
+                c->m_order.splice(c->m_order.begin(), c->m_order, it->second);
+                return r->plays;
+            }
+
+            if (!r->plays) {
+                if ((!c->m_loader) || (!c->m_loader->load(r))) {
+                    return NULL;
+                }
             }
 
-            if (best == m_lineup.end()) return player_tag();
+            c->m_order.push_front(r->id());
+            c->m_entries[r->id().key] = c->m_order.begin();
 
-            return best->first;
+            while (c->m_order.size() > c->m_capacity) {
+                c->evict();
+            }
+
+            return r->plays;
         }
 
 
-        Lineup::LineupList::iterator
-        Lineup::findOrder(uint o, bool visitor)
+        void Cache::clear()
         {
-            LineupList::iterator it = m_lineup.begin();
+            Cache* c = getInstance();
+
+            while (!c->m_order.empty()) {
+                c->evict();
+            }
+        }
 
-            while (it != m_lineup.end()) {
-                Card c = it->second;
 
-                if ((c.order == o) && (c.visiting == visitor)) return it;
+        void Cache::forget(const tag& t)
+        {
+            Cache* c = getInstance();
+            Entries::iterator it = c->m_entries.find(t.key);
 
-                it++;
+            if (it != c->m_entries.end()) {
+                c->m_order.erase(it->second);
+                c->m_entries.erase(it);
             }
+        }
+
 
-            return it;
+        void Cache::evict()
+        {
+            tag t = m_order.back();
+
+            m_order.pop_back();
+            m_entries.erase(t.key);
+
+            // the game may have been removed from the table since
+            Record* r = Table::get(t);
+
+            if ((r) && (r->source.isValid())) {
+                StateManager::removeChain(r->plays);
+                r->plays = NULL;
+            }
         }
     }
 }
@@ -22,11 +22,18 @@
 #include "bb_defs.h"
 #include "bb_record.h"
 #include "bb_state.h"
+#include "bb_statlog.h"
 
+#include <list>
 #include <map>
+#include <vector>
 #include <QDateTime>
+#include <QString>
 
 namespace Baseball {
+
+    class Snapshot;
+
     namespace Game {
 
         // A Instance is a unique game index denoted by a combination of data
@@ -77,13 +84,22 @@ namespace Baseball {
             uint m_sum;
         };
 
+        // The players of both teams in a game.  Each team has fixed slots for
+        // its batting order and its positions which hold the latest player put
+        // there, so the per-play lookups do not search.  Every start and sub
+        // line is kept in a history, in the order it was read, and each entry
+        // links to the one it replaced in its batting slot and position so that
+        // an earlier instance of the game can still be looked up.
         class Lineup
         {
+            friend class Baseball::Snapshot;
+
         public:
-            Lineup() {}
+            Lineup();
 
             // sub a player into the game, this can be used
-            // for starting lineups as well
+            // for starting lineups as well.  Returns true the first time the
+            // player appears in the game.
             bool sub(const player_tag& pt,
                      const Instance& inst,
                      const Position& p,
@@ -115,6 +131,9 @@ namespace Baseball {
 
         public:
 
+            // returns the latest card of player t, for a player who changed
+            // positions this is the card of the last sub, empty if the player
+            // is not in the game
             Card card(const player_tag& t) const;
 
             // returns the first player tag found at inst
@@ -134,18 +153,74 @@ namespace Baseball {
 
         private:
 
-            typedef std::map<player_tag, Card> LineupList;
+            // one start or sub line
+            struct Entry
+            {
+                Instance instance;
+
+                // index into m_players
+                quint16 player;
+
+                // the entries this one replaced in its position and batting
+                // slot, NO_ENTRY for the first
+                quint16 previousPosition;
+                quint16 previousOrder;
+
+                quint8 position;
+                quint8 order;
+                bool visiting;
+            };
+
+            static const quint16 NO_ENTRY;
+
+            enum {
+                // batting orders run 1-9, 0 is a pitcher who does not bat
+                MAX_ORDER = 10,
+                MAX_POSITION = PinchRunner + 1
+            };
+
+            // every player in the game in order of appearance, with the index
+            // of their latest entry
+            std::vector<player_tag> m_players;
+            std::vector<quint16> m_current;
+
+            std::vector<Entry> m_history;
+
+            // the latest entry for each batting slot and position, indexed by
+            // [visitor][slot]
+            quint16 m_order[2][MAX_ORDER];
+            quint16 m_position[2][MAX_POSITION];
+
+            // walks back from entry e through its previous entries to the
+            // latest one at or before after, or the earliest if there is none
+            player_tag latest(quint16 e,
+                              quint16 Entry::*previous,
+                              const Instance& after) const;
+        };
 
-            LineupList m_lineup;
 
-            LineupList::iterator findOrder(uint o, bool visitor);
+        // Where the play-by-play of a game is found in its event file, for a
+        // game which is only parsed when it is first used.  A game parsed up
+        // front has no source.
+        struct Source
+        {
+            Source() : offset(0), length(0) {}
+
+            bool isValid() const { return (length > 0); }
+
+            // path of the event file relative to the database root
+            QString fileName;
+
+            // byte range of the game, from its id line up to the next one
+            qint64 offset;
+            qint64 length;
         };
 
 
         class Record : public CoreRecord
         {
         public:
-            Record(const tag& ref) : CoreRecord(ref) {}
+            Record(const tag& ref) : CoreRecord(ref), plays(NULL) {}
 
             enum Type
             {
@@ -205,13 +280,78 @@ namespace Baseball {
             // this serves essentially as a list of all players who played in this game
             Lineup lineup;
 
-            // state lists
+            // state lists.  NULL for a game with a source until it is
+            // loaded, use Cache::plays to load it when needed.
             StateLink plays;
+
+            Source source;
+
+            // the changes this game makes to player statistics
+            StatLog stats;
         };
 
         class Table : public CoreTable<Record>
         {
 
         };
+
+
+        // Parses the play-by-play of a game from its source
+        class Loader
+        {
+        public:
+            virtual ~Loader() {}
+
+            // fills in r and creates its plays, returns false on error
+            virtual bool load(Record* r) = 0;
+        };
+
+
+        // Keeps the plays of the most recently used games which have a
+        // source.  Once more than capacity of them are loaded, the plays of
+        // the least recently used game are dropped again, leaving its
+        // record in the table.  Games without a source are never dropped.
+        class Cache : public Singleton<Cache>
+        {
+        public:
+            Cache();
+            ~Cache();
+
+            static const size_t DEFAULT_CAPACITY = 256;
+
+            // sets the loader used for games, the cache takes ownership of l
+            static void setLoader(Loader* l);
+
+            static void setCapacity(size_t n);
+
+            // returns the plays of r, loading them first if needed.  NULL if
+            // the game could not be loaded.
+            static StateLink plays(Record* r);
+
+            // number of loaded games held by the cache
+            static size_t count() { return getInstance()->m_order.size(); }
+
+            // drops the plays of every game held by the cache
+            static void clear();
+
+            // drops the entry for the game t without touching its record,
+            // for a game which is being removed from the table or replaced.
+            // The caller removes the plays of the game.
+            static void forget(const tag& t);
+
+        private:
+
+            void evict();
+
+            typedef std::list<tag> Order;
+            typedef std::map<tag_key, Order::iterator> Entries;
+
+            // most recently used first
+            Order m_order;
+            Entries m_entries;
+
+            Loader* m_loader;
+            size_t m_capacity;
+        };
     }
 }
@@ -0,0 +1,118 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "bb_manifest.h"
+#include "bb_game.h"
+#include "bb_state.h"
+
+#include <algorithm>
+
+namespace Baseball {
+
+    Manifest::~Manifest()
+    {
+        clear();
+    }
+
+
+    Manifest::Entry* Manifest::find(const QString& path)
+    {
+        Entries::iterator it = getInstance()->m_entries.find(path);
+
+        if (it != getInstance()->m_entries.end()) {
+            return it->second;
+        }
+
+        return NULL;
+    }
+
+
+    Manifest::Entry* Manifest::add(const QString& path)
+    {
+        Entry*& e = getInstance()->m_entries[path];
+
+        delete e;
+        e = new Entry;
+
+        return e;
+    }
+
+
+    void Manifest::retract(const QString& path)
+    {
+        Entries::iterator it = getInstance()->m_entries.find(path);
+
+        if (it == getInstance()->m_entries.end()) return;
+
+        Entry* e = it->second;
+        std::vector<Game::Record*> games;
+        std::vector<const StatLog*> logs;
+
+        for (unsigned int i = 0; i < e->games.size(); i++) {
+            Game::Record* g = Game::Table::remove(e->games[i]);
+
+            if (g) {
+                games.push_back(g);
+                logs.push_back(&g->stats);
+            }
+        }
+
+        StatLog::reduce(logs, true);
+
+        for (unsigned int i = 0; i < games.size(); i++) {
+            Game::Cache::forget(games[i]->id());
+            StateManager::removeChain(games[i]->plays);
+            delete games[i];
+        }
+
+        delete e;
+
+        getInstance()->m_entries.erase(it);
+    }
+
+
+    void Manifest::releaseGame(const tag& t)
+    {
+        Entries::iterator it = getInstance()->m_entries.begin();
+
+        for (; it != getInstance()->m_entries.end(); it++) {
+            std::vector<tag>& games = it->second->games;
+            std::vector<tag>::iterator gt = std::find(games.begin(), games.end(), t);
+
+            if (gt != games.end()) {
+                games.erase(gt);
+                return;
+            }
+        }
+    }
+
+
+    void Manifest::clear()
+    {
+        Entries::iterator it = getInstance()->m_entries.begin();
+
+        while (it != getInstance()->m_entries.end()) {
+            delete it->second;
+            it++;
+        }
+
+        getInstance()->m_entries.clear();
+        getInstance()->m_years.clear();
+    }
+}
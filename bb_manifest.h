@@ -0,0 +1,108 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "bb_defs.h"
+#include "bb_player.h"
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+
+#include <map>
+#include <vector>
+
+namespace Baseball {
+
+    class Snapshot;
+
+    // The manifest records every source file that went into the tables,
+    // along with the games parsed from it.  It lets a refresh find the files
+    // which changed since the tables were built, and take back what an old
+    // copy of a file contributed before parsing the new one.  What a file
+    // added to player statistics is taken back through the StatLog of each
+    // of its games.
+    //
+    // Paths are relative to the database root.
+    class Manifest : public Singleton<Manifest>
+    {
+        friend class Baseball::Snapshot;
+
+    public:
+
+        struct Entry
+        {
+            Entry() : size(0) {}
+
+            qint64 size;
+            QDateTime modified;
+
+            // SHA-1 of the file contents
+            QByteArray hash;
+
+            // games created from this file
+            std::vector<tag> games;
+
+        private:
+            Entry(const Entry&);
+            Entry& operator=(const Entry&);
+        };
+
+        typedef std::map<QString, Entry*> Entries;
+
+        ~Manifest();
+
+        // returns the entry for path, or NULL
+        static Entry* find(const QString& path);
+
+        // creates an empty entry for path, replacing any entry already
+        // recorded for it.  The data of a replaced entry is left in the
+        // tables, call retract first to take it back.
+        static Entry* add(const QString& path);
+
+        // subtracts the statistics of the games of the entry for path from
+        // the player table, removes the games from the game table and the
+        // state manager, and forgets the entry
+        static void retract(const QString& path);
+
+        // removes the game t from the entry which created it, for a game
+        // replaced by one of the same id from another file.  Retracting
+        // the old file then leaves the new game alone.
+        static void releaseGame(const tag& t);
+
+        // forgets every entry and the years
+        static void clear();
+
+        // the years the tables were built from, empty if every year was.
+        // A refresh only looks at these years.
+        static void setYears(const QList<int>& years) { getInstance()->m_years = years; }
+        static const QList<int>& years() { return getInstance()->m_years; }
+
+        static size_t count() { return getInstance()->m_entries.size(); }
+
+        static const Entries& entries() { return getInstance()->m_entries; }
+
+    protected:
+
+        Entries m_entries;
+        QList<int> m_years;
+    };
+}
@@ -0,0 +1,232 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "bb_play.h"
+#include "bb_game.h"
+
+#include <algorithm>
+
+namespace Baseball {
+
+    void PlayTable::clear()
+    {
+        m_type.clear();
+        m_inning.clear();
+        m_visiting.clear();
+        m_batter.clear();
+        m_pitcher.clear();
+        m_event.clear();
+        m_runs.clear();
+        m_pitchOffset.assign(1, 0);
+        m_pitches.clear();
+        m_pitchCount.clear();
+        m_game.clear();
+        m_games.clear();
+    }
+
+
+    void PlayTable::append(const State& st, unsigned int game)
+    {
+        m_type.push_back(static_cast<unsigned char>(st.type));
+        m_inning.push_back(static_cast<unsigned char>(st.inning));
+        m_visiting.push_back(st.visiting ? 1 : 0);
+        m_batter.push_back(st.batter.tag.key.head);
+        m_pitcher.push_back(st.pitcher.tag.key.head);
+        m_event.push_back(static_cast<unsigned char>(st.event.type));
+        m_runs.push_back(static_cast<unsigned char>(st.event.runsScored));
+
+        m_pitches.insert(m_pitches.end(),
+                         st.pitches.data(),
+                         st.pitches.data() + st.pitches.size());
+
+        m_pitchOffset.push_back(m_pitches.size());
+
+        const unsigned char* b = st.pitches.data();
+        unsigned char thrown = 0;
+
+        for (size_t i = 0; i < st.pitches.size(); i++) {
+            if (!(b[i] & Pitches::PICKOFF)) {
+                thrown++;
+            }
+        }
+
+        m_pitchCount.push_back(thrown);
+        m_game.push_back(game);
+    }
+
+
+    void PlayTable::build()
+    {
+        PlayTable* pt = getInstance();
+
+        pt->clear();
+
+        pt->m_type.reserve(StateManager::live());
+
+        for (Game::Table::Reference it = Game::Table::begin();
+             it != Game::Table::end(); it.next()) {
+            Game::Record* g = it.record();
+            unsigned int game = pt->m_games.size();
+
+            pt->m_games.push_back(g->id());
+
+            // the plays of a stub are loaded through the cache, the rows
+            // are copied so the cache may drop them again afterwards
+            StateLink plays = Game::Cache::plays(g);
+
+            // the last state of a chain follows the final play of the game,
+            // and holds no play of its own
+            for (StateLink st = plays; (st) && (st->gameLink); st = st->gameLink) {
+                pt->append(*st, game);
+            }
+        }
+    }
+
+
+    PlayTable::Selection PlayTable::all()
+    {
+        return Selection(count(), 1);
+    }
+
+
+    void PlayTable::whereRunners(Selection& sel, unsigned int bases)
+    {
+        const unsigned char* type = getInstance()->m_type.data();
+        size_t n = std::min(sel.size(), count());
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= (((type[i] & bases) == bases) &&
+                       (type[i] >= State::S___0) &&
+                       (type[i] < State::SENDHALF));
+        }
+    }
+
+
+    void PlayTable::whereOuts(Selection& sel, unsigned int maxOuts)
+    {
+        const unsigned char* type = getInstance()->m_type.data();
+        size_t n = std::min(sel.size(), count());
+
+        // the high nibble of a base/out state is the number of outs plus one
+        unsigned int limit = ((maxOuts + 2) << 4);
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= ((type[i] >= State::S___0) &&
+                       (type[i] < limit) &&
+                       (type[i] < State::SENDHALF));
+        }
+    }
+
+
+    void PlayTable::whereInning(Selection& sel, unsigned int first, unsigned int last)
+    {
+        const unsigned char* inning = getInstance()->m_inning.data();
+        size_t n = std::min(sel.size(), count());
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= ((inning[i] >= first) && (inning[i] <= last));
+        }
+    }
+
+
+    void PlayTable::whereEvent(Selection& sel, const Event::Type& t)
+    {
+        const unsigned char* event = getInstance()->m_event.data();
+        size_t n = std::min(sel.size(), count());
+        unsigned char e = static_cast<unsigned char>(t);
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= (event[i] == e);
+        }
+    }
+
+
+    void PlayTable::whereVisiting(Selection& sel, bool visiting)
+    {
+        const unsigned char* v = getInstance()->m_visiting.data();
+        size_t n = std::min(sel.size(), count());
+        unsigned char b = (visiting ? 1 : 0);
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= (v[i] == b);
+        }
+    }
+
+
+    void PlayTable::whereBatter(Selection& sel, const player_tag& t)
+    {
+        const unsigned long long* batter = getInstance()->m_batter.data();
+        size_t n = std::min(sel.size(), count());
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= (batter[i] == t.key.head);
+        }
+    }
+
+
+    void PlayTable::wherePitcher(Selection& sel, const player_tag& t)
+    {
+        const unsigned long long* pitcher = getInstance()->m_pitcher.data();
+        size_t n = std::min(sel.size(), count());
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= (pitcher[i] == t.key.head);
+        }
+    }
+
+
+    unsigned int PlayTable::count(const Selection& sel)
+    {
+        unsigned int c = 0;
+
+        for (size_t i = 0; i < sel.size(); i++) {
+            c += sel[i];
+        }
+
+        return c;
+    }
+
+
+    unsigned int PlayTable::runs(const Selection& sel)
+    {
+        const unsigned char* runs = getInstance()->m_runs.data();
+        size_t n = std::min(sel.size(), count());
+        unsigned int c = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            c += (sel[i] * runs[i]);
+        }
+
+        return c;
+    }
+
+
+    unsigned int PlayTable::pitches(const Selection& sel)
+    {
+        const unsigned char* thrown = getInstance()->m_pitchCount.data();
+        size_t n = std::min(sel.size(), count());
+        unsigned int c = 0;
+
+        for (size_t i = 0; i < n; i++) {
+            c += (sel[i] * thrown[i]);
+        }
+
+        return c;
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "bb_defs.h"
+#include "bb_state.h"
+
+#include <vector>
+
+namespace Baseball {
+
+    // The PlayTable holds every play of every game in the game table as a
+    // set of columns, one entry per play in each, so that questions over
+    // all plays are answered by scanning a few arrays rather than walking
+    // state chains.  It is a copy, and has to be rebuilt after the games or
+    // their states change.
+    //
+    // Plays are filtered through a Selection, which has one flag per play.
+    // Every where function clears the flags of the plays which do not match
+    // and leaves the others alone, so calls combine as "and".
+    class PlayTable : public Singleton<PlayTable>
+    {
+    public:
+
+        typedef std::vector<unsigned char> Selection;
+
+        // rebuilds the table from the state chain of every game
+        static void build();
+
+        static size_t count() { return getInstance()->m_type.size(); }
+
+        // returns a selection of every play
+        static Selection all();
+
+        // plays with a runner on (at least) every base set in bases, bases
+        // is a combination of the RUNNER_ flags
+        static void whereRunners(Selection& sel, unsigned int bases);
+
+        // plays starting with at most maxOuts outs
+        static void whereOuts(Selection& sel, unsigned int maxOuts);
+
+        static void whereInning(Selection& sel, unsigned int first, unsigned int last);
+        static void whereEvent(Selection& sel, const Event::Type& t);
+        static void whereVisiting(Selection& sel, bool visiting);
+        static void whereBatter(Selection& sel, const player_tag& t);
+        static void wherePitcher(Selection& sel, const player_tag& t);
+
+        // number of selected plays
+        static unsigned int count(const Selection& sel);
+
+        // runs scored on the selected plays
+        static unsigned int runs(const Selection& sel);
+
+        // pitches thrown on the selected plays
+        static unsigned int pitches(const Selection& sel);
+
+        // bits of a state type giving the occupied bases
+        enum {
+            RUNNER_THIRD  = 0x1,
+            RUNNER_SECOND = 0x2,
+            RUNNER_FIRST  = 0x4
+        };
+
+    protected:
+
+        // the state type of each play, which gives the runners and outs
+        // before the play
+        std::vector<unsigned char> m_type;
+        std::vector<unsigned char> m_inning;
+        std::vector<unsigned char> m_visiting;
+
+        // packed tags of the batter and pitcher, see tag_key.  Player ids
+        // are eight characters, so the head of the key identifies them.
+        std::vector<unsigned long long> m_batter;
+        std::vector<unsigned long long> m_pitcher;
+
+        // Event::Type of each play
+        std::vector<unsigned char> m_event;
+        std::vector<unsigned char> m_runs;
+
+        // the packed pitches of play i, see Pitches, are
+        // m_pitches[m_pitchOffset[i]] up to m_pitches[m_pitchOffset[i + 1]],
+        // so there is one more offset than there are plays
+        std::vector<unsigned int> m_pitchOffset;
+        std::vector<unsigned char> m_pitches;
+
+        // pitches thrown on each play, which leaves out the pickoff throws
+        // held in m_pitches
+        std::vector<unsigned char> m_pitchCount;
+
+        // index of the game of each play in m_games
+        std::vector<unsigned int> m_game;
+        std::vector<tag> m_games;
+
+        void clear();
+        void append(const State& st, unsigned int game);
+    };
+}
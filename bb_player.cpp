@@ -19,12 +19,55 @@
  */
 #include "bb_player.h"
 
+#include <algorithm>
 #include <stdio.h>
 #include <sstream>
 
 namespace Baseball {
     namespace Player {
 
+        namespace {
+
+            // adds a print column for each statistic of a group
+            struct AddColumn
+            {
+                AddColumn(Stat::Print& p, unsigned int r) : printer(p), rows(r), column(0) {}
+
+                void operator()(Stat::Id, const char* label, const Stat::Bin&)
+                {
+                    printer.addColumn(column, label, rows);
+                    column++;
+                }
+
+                Stat::Print& printer;
+                unsigned int rows;
+                int column;
+            };
+
+            // sets the print columns of one row to the statistics of a group
+            struct SetColumn
+            {
+                SetColumn(Stat::Print& p, int r) : printer(p), row(r), column(0) {}
+
+                void operator()(Stat::Id, const char*, const Stat::Bin& b)
+                {
+                    printer.set(&b, row, column);
+                    column++;
+                }
+
+                Stat::Print& printer;
+                int row;
+                int column;
+            };
+
+            bool yearBefore(const std::pair<Record::TeamYear, Record::Year>& y,
+                            const Record::TeamYear& yr)
+            {
+                return (y.first < yr);
+            }
+        }
+
+
         const Record::Year Record::NULL_YEAR;
 
         Record::Year& Record::operator[](TeamYear yr)
@@ -39,20 +82,72 @@ namespace Baseball {
 
         Record::Year& Record::year(TeamYear yr)
         {
-            return m_years[yr];
+            // years mostly arrive in order, so most are appended
+            if ((m_years.empty()) || (m_years.back().first < yr)) {
+                m_years.push_back(std::make_pair(yr, Year()));
+                return m_years.back().second;
+            }
+
+            Years::iterator it = std::lower_bound(m_years.begin(), m_years.end(), yr, yearBefore);
+
+            if ((it == m_years.end()) || (yr < it->first)) {
+                it = m_years.insert(it, std::make_pair(yr, Year()));
+            }
+
+            return it->second;
         }
 
         const Record::Year& Record::year(TeamYear yr) const
         {
-            Years::const_iterator it = m_years.find(yr);
+            Years::const_iterator it = std::lower_bound(m_years.begin(), m_years.end(), yr, yearBefore);
 
-            if (it != m_years.end()) {
+            if ((it != m_years.end()) && (false == (yr < it->first))) {
                 return it->second;
             }
 
             return NULL_YEAR;
         }
 
+        Stat::Bin& Record::Year::stat(Stat::Id id)
+        {
+#           define BATTING_CASE(G, M, L)       case Stat::G##M: return batting.M;
+#           define FIELDING_CASE(G, M, L)      case Stat::G##M: return fielding.M;
+#           define PITCHING_CASE(G, M, L)      case Stat::G##M: return pitching.M;
+#           define BASERUNNING_CASE(G, M, L)   case Stat::G##M: return baseRunning.M;
+#           define GENERAL_CASE(G, M, L)       case Stat::G##M: return general.M;
+
+            switch (id) {
+            STAT_BATTING(BATTING_CASE)
+            STAT_FIELDING(FIELDING_CASE)
+            STAT_PITCHING(PITCHING_CASE)
+            STAT_BASERUNNING(BASERUNNING_CASE)
+            STAT_GENERAL(GENERAL_CASE)
+            case Stat::NUM_IDS:
+                break;
+            }
+
+#           undef BATTING_CASE
+#           undef FIELDING_CASE
+#           undef PITCHING_CASE
+#           undef BASERUNNING_CASE
+#           undef GENERAL_CASE
+
+            // id is not a statistic.  Whatever the caller does with the bin
+            // lands in a scratch bin, not in one of the statistics.
+            assert(false);
+
+            static Stat::Bin invalid;
+
+            invalid = 0;
+
+            return invalid;
+        }
+
+        const Stat::Bin& Record::Year::stat(Stat::Id id) const
+        {
+            return const_cast<Year*>(this)->stat(id);
+        }
+
         bool Record::TeamYear::operator<(const Record::TeamYear& rhs) const
         {
             if (type < rhs.type) { return true; }
@@ -60,13 +155,13 @@ namespace Baseball {
             else {
                 switch (type) {
                 case TEAM:
-                    return (tm < rhs.tm);
+                    return (tm.key < rhs.tm.key);
                     break;
                 case TEAMYEAR:
-                    if (tm < rhs.tm) { return true; }
-                    else if (rhs.tm < tm) { return false; }
+                    if (yr < rhs.yr) { return true; }
+                    else if (rhs.yr < yr) { return false; }
                     else {
-                        return (yr < rhs.yr);
+                        return (tm.key < rhs.tm.key);
                     }
                     break;
                 case YEAR:
@@ -74,6 +169,8 @@ namespace Baseball {
                     break;
                 }
             }
+
+            return false;
         }
 
 
@@ -132,6 +229,45 @@ namespace Baseball {
             return list;
         }
 
+        void Record::merge(const Record& rhs)
+        {
+            Years::const_iterator it = rhs.m_years.begin();
+
+            for (; it != rhs.m_years.end(); it++) {
+                Year& y = year(it->first);
+
+                if (!it->second.isNull()) {
+                    y.validate();
+                }
+
+                y.batting     += it->second.batting;
+                y.fielding    += it->second.fielding;
+                y.pitching    += it->second.pitching;
+                y.baseRunning += it->second.baseRunning;
+                y.general     += it->second.general;
+            }
+        }
+
+        void Record::unmerge(const Record& rhs)
+        {
+            Years::const_iterator it = rhs.m_years.begin();
+
+            for (; it != rhs.m_years.end(); it++) {
+                Years::iterator yt = std::lower_bound(m_years.begin(), m_years.end(),
+                                                      it->first, yearBefore);
+
+                if ((yt == m_years.end()) || (it->first < yt->first)) continue;
+
+                Year& y = yt->second;
+
+                y.batting     -= it->second.batting;
+                y.fielding    -= it->second.fielding;
+                y.pitching    -= it->second.pitching;
+                y.baseRunning -= it->second.baseRunning;
+                y.general     -= it->second.general;
+            }
+        }
+
         std::string Record::printCategory(const Stat::Category& cat) const
         {
             switch (cat) {
@@ -150,51 +286,24 @@ namespace Baseball {
         }
 
 
-        std::string Record::printBatting() const
+        template<typename G>
+        std::string Record::printGroup(G Year::* group) const
         {
-            static const int nStats = 18;
-            static const std::string coll[nStats] = {
-                "PA", "AB", "1B", "2B", "GDR", "3B", "HR", "RBI",
-                "HBP", "K", "BB", "IBB", "SF", "SH",
-                "FC", "DP", "RBOE", "INT"
-            };
-
             Stat::Print printer(m_years.size());
             StringList szl;
 
             // create columns
-            for (int i = 0; i < nStats; i++) {
-                printer.addColumn(i, coll[i], m_years.size());
-            }
+            AddColumn add(printer, m_years.size());
+
+            G().eachPrinted(add);
 
             // enumerate years
-            Years::const_iterator it = m_years.begin();
-            int row = 0;
-
-            while (it != m_years.end()) {
-                printer.set(&(it->second.batting.PA), row, 0);
-                printer.set(&(it->second.batting.AB), row, 1);
-                printer.set(&(it->second.batting.H1B), row, 2);
-                printer.set(&(it->second.batting.H2B), row, 3);
-                printer.set(&(it->second.batting.GDR), row, 4);
-                printer.set(&(it->second.batting.H3B), row, 5);
-                printer.set(&(it->second.batting.HR), row, 6);
-                printer.set(&(it->second.batting.RBI), row, 7);
-                printer.set(&(it->second.batting.HBP), row, 8);
-                printer.set(&(it->second.batting.K), row, 9);
-                printer.set(&(it->second.batting.BB), row, 10);
-                printer.set(&(it->second.batting.IBB), row, 11);
-                printer.set(&(it->second.batting.SF), row, 12);
-                printer.set(&(it->second.batting.SH), row, 13);
-                printer.set(&(it->second.batting.FC), row, 14);
-                printer.set(&(it->second.batting.DP), row, 15);
-                printer.set(&(it->second.batting.RBOE), row, 16);
-                printer.set(&(it->second.batting.INT), row, 17);
-
-                szl.push_back(it->first.toString());
-
-                row++;
-                it++;
+            for (size_t row = 0; row < m_years.size(); row++) {
+                SetColumn set(printer, row);
+
+                (m_years[row].second.*group).eachPrinted(set);
+
+                szl.push_back(m_years[row].first.toString());
             }
 
             printer.setRowLabels(szl);
@@ -203,95 +312,39 @@ namespace Baseball {
         }
 
 
-        std::string Record::printFielding() const
+        std::string Record::printBatting() const
         {
-            static const int nStats = 3;
-            static const std::string coll[nStats] = {
-                "PO",
-                "A",
-                "E"
-            };
-
-            Stat::Print printer(m_years.size());
-            StringList szl;
-
-            // create columns
-            for (int i = 0; i < nStats; i++) {
-                printer.addColumn(i, coll[i], m_years.size());
-            }
-
-            // enumerate years
-            Years::const_iterator it = m_years.begin();
-            int row = 0;
-
-            while (it != m_years.end()) {
-                printer.set(&(it->second.fielding.PO), row, 0);
-                printer.set(&(it->second.fielding.A), row, 1);
-                printer.set(&(it->second.fielding.E), row, 2);
-
-                szl.push_back(it->first.toString());
-
-                row++;
-                it++;
-            }
+            return printGroup(&Year::batting);
+        }
 
-            printer.setRowLabels(szl);
 
-            return printer.print();
+        std::string Record::printFielding() const
+        {
+            return printGroup(&Year::fielding);
         }
 
 
         std::string Record::printPitching() const
         {
-            return std::string();
+            return printGroup(&Year::pitching);
         }
 
 
         std::string Record::printBaseRunning() const
         {
-            return std::string();
+            return printGroup(&Year::baseRunning);
         }
 
 
         std::string Record::printGeneral() const
         {
-            static const int nStats = 2;
-            static const std::string coll[nStats] = {
-                "GS",
-                "GP"
-            };
-
-            Stat::Print printer(m_years.size());
-            StringList szl;
-
-            // create columns
-            for (int i = 0; i < nStats; i++) {
-                printer.addColumn(i, coll[i], m_years.size());
-            }
-
-            // enumerate years
-            Years::const_iterator it = m_years.begin();
-            int row = 0;
-
-            while (it != m_years.end()) {
-                printer.set(&(it->second.general.GS), row, 0);
-                printer.set(&(it->second.general.GP), row, 1);
-
-                szl.push_back(it->first.toString());
-
-                row++;
-                it++;
-            }
-
-            printer.setRowLabels(szl);
-
-            return printer.print();
+            return printGroup(&Year::general);
         }
 
         // approx.
         unsigned long Record::weight() const
         {
-            return (firstName.length() + surName.length() + sizeof(Year) * m_years.size());
+            return (firstName.length() + surName.length() + sizeof(Years::value_type) * m_years.size());
         }
     }
 
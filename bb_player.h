@@ -22,10 +22,15 @@
 #include "bb_record.h"
 #include "bb_stat.h"
 
+#include <utility>
 #include <vector>
 #include <QDate>
 
 namespace Baseball {
+
+    class Snapshot;
+    class StatTable;
+
     namespace Player {
 
         enum Handedness
@@ -38,6 +43,9 @@ namespace Baseball {
 
         class Record : public CoreRecord
         {
+            friend class Baseball::Snapshot;
+            friend class Baseball::StatTable;
+
         public:
             Record(const tag& p) : CoreRecord(p) {}
 
@@ -69,6 +77,8 @@ namespace Baseball {
                 int yr;
                 team_tag tm;
 
+                // orders by year and then team, comparing the packed team
+                // keys rather than the characters of the tags
                 bool operator<(const TeamYear& rhs) const;
 
                 std::string toString() const;
@@ -99,6 +109,30 @@ namespace Baseball {
                 Stat::Pitching pitching;
                 Stat::BaseRunning baseRunning;
                 Stat::General general;
+
+                // the bin of the statistic id
+                Stat::Bin& stat(Stat::Id id);
+                const Stat::Bin& stat(Stat::Id id) const;
+
+                // calls f(id, label, bin) for every statistic of the year,
+                // in Id order
+                template<typename F> void each(F& f)
+                {
+                    batting.each(f);
+                    fielding.each(f);
+                    pitching.each(f);
+                    baseRunning.each(f);
+                    general.each(f);
+                }
+
+                template<typename F> void each(F& f) const
+                {
+                    batting.each(f);
+                    fielding.each(f);
+                    pitching.each(f);
+                    baseRunning.each(f);
+                    general.each(f);
+                }
             };
 
             typedef bool (*filterFunc)(const Year&);
@@ -112,7 +146,10 @@ namespace Baseball {
             std::string printCategory(const Stat::Category& cat) const;
 
             // adds a year if not already in the record, or returns
-            // the given year
+            // the given year.  Threads sharing a record hold its
+            // Table::recordLock while calling this and changing the year.
+            // Adding a year moves the others, so the returned reference is
+            // only good until the next year is added.
             Year& year(TeamYear yr);
             Year& operator[](TeamYear yr);
 
@@ -123,6 +160,22 @@ namespace Baseball {
 
             YearList filter(filterFunc func = NULL) const;
 
+            // the years of this player sorted by TeamYear, kept in one block
+            // so career totals and printing walk them in order
+            typedef std::vector<std::pair<TeamYear, Year> > Years;
+
+            // the years on record, without copying them as filter does
+            const Years& years() const { return m_years; }
+
+            // adds the statistics of every year in rhs to this record,
+            // creating years as needed.  Handedness and other roster data
+            // in this record are left untouched.
+            void merge(const Record& rhs);
+
+            // subtracts the statistics of every year in rhs from this
+            // record, undoing an earlier merge of rhs
+            void unmerge(const Record& rhs);
+
         private:
 
             std::string printBatting() const;
@@ -131,9 +184,11 @@ namespace Baseball {
             std::string printBaseRunning() const;
             std::string printGeneral() const;
 
-        protected:
+            // prints one stat group of every year, a column for each
+            // statistic of the group
+            template<typename G> std::string printGroup(G Year::* group) const;
 
-            typedef std::map<TeamYear, Year> Years;
+        protected:
 
             Years m_years;
         };
@@ -99,7 +99,20 @@ namespace Baseball {
     //                                                                       //
     ///////////////////////////////////////////////////////////////////////////
 
+    unsigned int tag_hash(const tag_key& key)
+    {
+        // 64 bit finalizer from MurmurHash3
+        unsigned long long h = key.head ^ (key.tail * 0x9e3779b97f4a7c15ULL);
+
+        h ^= (h >> 33);
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= (h >> 33);
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= (h >> 33);
 
+        // 0 marks an empty slot in the index
+        return ((static_cast<unsigned int>(h)) ? static_cast<unsigned int>(h) : 1);
+    }
 
     ///////////////////////////////////////////////////////////////////////////
     //                                                                       //
@@ -25,6 +25,9 @@
 #include <map>
 #include <set>
 
+#include <QMutex>
+#include <QMutexLocker>
+
 namespace Baseball {
 
     template<typename R> class CoreTable;
@@ -77,6 +80,7 @@ namespace Baseball {
     {
     public:
         CoreRecord(const tag& t);
+        virtual ~CoreRecord() {}
 
         virtual std::string print() const;
 
@@ -103,6 +107,156 @@ namespace Baseball {
     };
 
 
+    // returns a non-zero hash of a packed tag
+    unsigned int tag_hash(const tag_key& key);
+
+    // An open addressing hash index from tags to records.  Keys are the
+    // packed (case folded) tags, and every slot keeps the hash of its key,
+    // so a probe only compares keys when the hashes are equal.
+    template<typename R>
+    class TagIndex
+    {
+    public:
+        TagIndex() : m_slots(NULL), m_capacity(0), m_count(0) {}
+        ~TagIndex() { delete[] m_slots; }
+
+        // returns the record stored for key, or NULL
+        R* find(const tag_key& key) const
+        {
+            if (m_count == 0) return static_cast<R*>(0);
+
+            unsigned int h = tag_hash(key);
+            size_t mask = m_capacity - 1;
+
+            for (size_t i = (h & mask); m_slots[i].hash != 0; i = ((i + 1) & mask)) {
+                if ((m_slots[i].hash == h) && (m_slots[i].key == key)) {
+                    return m_slots[i].value;
+                }
+            }
+
+            return static_cast<R*>(0);
+        }
+
+        // stores val for key, replacing any record already stored
+        void insert(const tag_key& key, R* val)
+        {
+            // the index is kept at most half full
+            if (((m_count + 1) * 2) > m_capacity) {
+                grow();
+            }
+
+            unsigned int h = tag_hash(key);
+            size_t mask = m_capacity - 1;
+            size_t i = (h & mask);
+
+            for (; m_slots[i].hash != 0; i = ((i + 1) & mask)) {
+                if ((m_slots[i].hash == h) && (m_slots[i].key == key)) {
+                    m_slots[i].value = val;
+                    return;
+                }
+            }
+
+            m_slots[i].hash = h;
+            m_slots[i].key = key;
+            m_slots[i].value = val;
+
+            m_count++;
+        }
+
+        // removes key from the index, returns false if it was not stored
+        bool remove(const tag_key& key)
+        {
+            if (m_count == 0) return false;
+
+            unsigned int h = tag_hash(key);
+            size_t mask = m_capacity - 1;
+            size_t i = (h & mask);
+
+            for (; m_slots[i].hash != 0; i = ((i + 1) & mask)) {
+                if ((m_slots[i].hash == h) && (m_slots[i].key == key)) {
+                    break;
+                }
+            }
+
+            if (m_slots[i].hash == 0) return false;
+
+            // shift the rest of the cluster back over the hole, so that no
+            // probe for a later key stops early.  A slot may only move if
+            // its home slot is not between the hole and itself.
+            for (size_t j = ((i + 1) & mask); m_slots[j].hash != 0; j = ((j + 1) & mask)) {
+                size_t home = (m_slots[j].hash & mask);
+                bool between = ((i <= j) ? ((i < home) && (home <= j))
+                                         : ((i < home) || (home <= j)));
+
+                if (!between) {
+                    m_slots[i] = m_slots[j];
+                    i = j;
+                }
+            }
+
+            m_slots[i] = Slot();
+            m_count--;
+
+            return true;
+        }
+
+        size_t count() const { return m_count; }
+
+        // empties the index, the records are not deleted
+        void clear()
+        {
+            delete[] m_slots;
+
+            m_slots = NULL;
+            m_capacity = 0;
+            m_count = 0;
+        }
+
+    protected:
+
+        struct Slot {
+            Slot() : hash(0), value(static_cast<R*>(0)) {}
+
+            // 0 if this slot is empty
+            unsigned int hash;
+            tag_key key;
+            R* value;
+        };
+
+        void grow()
+        {
+            size_t capacity = ((m_capacity) ? (m_capacity * 2) : 64);
+            Slot* grown = new Slot[capacity];
+            size_t mask = capacity - 1;
+
+            for (size_t i = 0; i < m_capacity; i++) {
+                if (m_slots[i].hash != 0) {
+                    size_t j = (m_slots[i].hash & mask);
+
+                    while (grown[j].hash != 0) {
+                        j = ((j + 1) & mask);
+                    }
+
+                    grown[j] = m_slots[i];
+                }
+            }
+
+            delete[] m_slots;
+
+            m_slots = grown;
+            m_capacity = capacity;
+        }
+
+        Slot* m_slots;
+        size_t m_capacity;
+        size_t m_count;
+
+    private:
+        TagIndex(const TagIndex&);
+        TagIndex& operator=(const TagIndex&);
+    };
+
+
     template<typename R>
     class CoreReference;
 
@@ -112,7 +266,7 @@ namespace Baseball {
     {
         friend class CoreReference<R>;
     public:
-        CoreTable() {}
+        CoreTable() : m_generation(0) {}
 
         ~CoreTable() {
             Table::iterator it = m_table.begin();
@@ -123,6 +277,15 @@ namespace Baseball {
             }
 
             m_table.clear();
+
+            for (unsigned int i = 0; i < SHARED_STRIPES; i++) {
+                it = m_stripes[i].pending.begin();
+
+                while (it != m_stripes[i].pending.end()) {
+                    delete it->second;
+                    it++;
+                }
+            }
         }
 
         typedef std::list<R*> RecordList;
@@ -130,26 +293,24 @@ namespace Baseball {
         static R* get(const std::string& ref)
         {
             // create tag reference;
-            tag_ref t;
-            tag_cpy_s(t.s, ref.c_str(), ref.length());
+            tag t;
+            t.set(ref.c_str(), ref.length());
 
             // lookup tag
-            Table::iterator it = getInstance()->m_table.find(t);
-
-            if (it != getInstance()->m_table.end()) {
-                return it->second;
-            }
-
-            return static_cast<R*>(0);
+            return getInstance()->m_index.find(t.key);
         }
 
         static R* get(const tag& ref)
         {
-            tag_ref t;
-            tag_cpy(t.s, ref.ref);
+            return getInstance()->m_index.find(ref.key);
+        }
 
+        // looks up ref in the ordered table rather than the index.  This
+        // is slower than get, and only kept to compare the two.
+        static R* getOrdered(const tag& ref)
+        {
             // lookup tag
-            Table::iterator it = getInstance()->m_table.find(t);
+            Table::iterator it = getInstance()->m_table.find(ref.key);
 
             if (it != getInstance()->m_table.end()) {
                 return it->second;
@@ -160,10 +321,61 @@ namespace Baseball {
 
         static void store(const tag& ref, R* val)
         {
-            tag_ref t;
-            tag_cpy(t.s, ref.ref);
+            getInstance()->m_table[ref.key] = val;
+            getInstance()->m_index.insert(ref.key, val);
+        }
+
+        // Removes the record for ref from the table and returns it, or NULL
+        // if there was none.  The caller owns the returned record.
+        static R* remove(const tag& ref)
+        {
+            Table::iterator it = getInstance()->m_table.find(ref.key);
+
+            if (it == getInstance()->m_table.end()) {
+                return static_cast<R*>(0);
+            }
+
+            R* r = it->second;
+
+            getInstance()->m_table.erase(it);
+            getInstance()->m_index.remove(ref.key);
+            getInstance()->m_generation++;
+
+            return r;
+        }
+
+        // deletes every record in the table, and any still pending from
+        // shared inserts
+        static void clear()
+        {
+            Table::iterator it = getInstance()->m_table.begin();
 
-            getInstance()->m_table[t] = val;
+            while (it != getInstance()->m_table.end()) {
+                delete it->second;
+                it++;
+            }
+
+            getInstance()->m_table.clear();
+            getInstance()->m_index.clear();
+
+            for (unsigned int i = 0; i < SHARED_STRIPES; i++) {
+                Table& pending = getInstance()->m_stripes[i].pending;
+
+                for (it = pending.begin(); it != pending.end(); it++) {
+                    delete it->second;
+                }
+
+                pending.clear();
+            }
+
+            getInstance()->m_generation++;
+        }
+
+        // changes whenever records leave the table, so that anything holding
+        // record pointers can tell they may no longer be valid
+        static unsigned int generation()
+        {
+            return getInstance()->m_generation;
         }
 
         // Creates a new record in the database, returing a pointer to
@@ -171,19 +383,13 @@ namespace Baseball {
         // behaves identical to get.
         static R* createRecord(const tag& ref)
         {
-            R* r = static_cast<R*>(0);
-            tag_ref t;
-
-            tag_cpy(t.s, ref.ref);
+            R* r = getInstance()->m_index.find(ref.key);
 
-            Table::iterator it = getInstance()->m_table.find(t);
-
-            if (it == getInstance()->m_table.end()) {
+            if (!isValid(r)) {
                 r = new R(ref);
 
-                getInstance()->m_table[t] = r;
-            } else {
-                r = it->second;
+                getInstance()->m_table[ref.key] = r;
+                getInstance()->m_index.insert(ref.key, r);
             }
 
             return r;
@@ -194,6 +400,89 @@ namespace Baseball {
             return getInstance()->m_table.size();
         }
 
+        // Shared inserts let several threads create records at once.  While
+        // they do, the ordered table and the index are only read, so get
+        // stays lock free; new records wait in one of SHARED_STRIPES pending
+        // maps, picked by the hash of the tag, each behind its own mutex.
+        // Records created this way are not seen by get, count or iteration
+        // until publishShared is called.
+        static const unsigned int SHARED_STRIPES = 16;
+
+        // returns the record for ref, whether it is in the table or still
+        // pending, or NULL.  Safe to call from several threads.
+        static R* getShared(const tag& ref)
+        {
+            R* r = getInstance()->m_index.find(ref.key);
+
+            if (isValid(r)) return r;
+
+            Stripe& s = getInstance()->stripe(ref.key);
+            QMutexLocker lock(&s.mutex);
+            Table::iterator it = s.pending.find(ref.key);
+
+            return ((it != s.pending.end()) ? it->second : static_cast<R*>(0));
+        }
+
+        // createRecord for several threads at once.  Every thread asking
+        // for the same tag gets the same record.
+        static R* createShared(const tag& ref)
+        {
+            R* r = getInstance()->m_index.find(ref.key);
+
+            if (isValid(r)) return r;
+
+            Stripe& s = getInstance()->stripe(ref.key);
+            QMutexLocker lock(&s.mutex);
+            R*& p = s.pending[ref.key];
+
+            if (!isValid(p)) {
+                p = new R(ref);
+            }
+
+            return p;
+        }
+
+        // The lock for changing the record of ref while other threads may
+        // change it too.  Tags share their stripe's lock, so a thread holds
+        // at most one of these at a time.
+        static QMutex* recordLock(const tag& ref)
+        {
+            return &getInstance()->stripe(ref.key).recordMutex;
+        }
+
+        // moves every pending record into the table, returning how many
+        // there were.  No thread may use the shared functions meanwhile.
+        // A pending record holds the changes made through the shared path,
+        // so if the table gained a record for the same tag in the meantime,
+        // that record is deleted and the pending one takes its place.
+        static size_t publishShared()
+        {
+            CoreTable<R>* t = getInstance();
+            size_t n = 0;
+
+            for (unsigned int i = 0; i < SHARED_STRIPES; i++) {
+                Table& pending = t->m_stripes[i].pending;
+                Table::iterator it = pending.begin();
+
+                for (; it != pending.end(); it++) {
+                    R*& r = t->m_table[it->first];
+
+                    if ((r) && (r != it->second)) {
+                        delete r;
+                        t->m_generation++;
+                    }
+
+                    r = it->second;
+                    t->m_index.insert(it->first, it->second);
+                    n++;
+                }
+
+                pending.clear();
+            }
+
+            return n;
+        }
+
         typedef bool (*filterFunc)(const R*);
 
         static RecordList filter(filterFunc func = NULL)
@@ -236,23 +525,28 @@ namespace Baseball {
 
     protected:
 
-        struct tag_ref {
-            char s[TAGLEN];
-            bool operator<(const tag_ref& rhs) const
-            {
-                int i = 0;
-                while ((i < (TAGLEN - 1)) &&
-                       (tolower(s[i]) == tolower(rhs.s[i])))
-                {
-                    i++;
-                }
-                return (tolower(s[i]) < tolower(rhs.s[i]));
-            }
+        typedef std::map<tag_key, R*> Table;
+
+        struct Stripe {
+            QMutex mutex;
+            QMutex recordMutex;
+            Table pending;
         };
 
-        typedef std::map<tag_ref, R*> Table;
+        Stripe& stripe(const tag_key& key)
+        {
+            // the index uses the low bits of the hash
+            return m_stripes[(tag_hash(key) >> 16) % SHARED_STRIPES];
+        }
 
+        // the table keeps records in tag order for iteration, lookups by tag
+        // go through the index
         Table m_table;
+        TagIndex<R> m_index;
+
+        unsigned int m_generation;
+
+        Stripe m_stripes[SHARED_STRIPES];
     };
 
     template<typename R>
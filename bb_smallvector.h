@@ -0,0 +1,127 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+
+namespace Baseball {
+
+    // A vector which holds its first N elements inside itself, and only
+    // allocates once it grows past them.  The per-play lists of outs,
+    // assists and runners are bounded by the rules of the game, so sizing N
+    // to those bounds means building a play makes no allocations.  Elements
+    // are kept contiguous, so iterators are plain pointers and are
+    // invalidated when the vector grows past its capacity.
+    template<typename T, unsigned int N>
+    class SmallVector
+    {
+    public:
+        typedef T* iterator;
+        typedef const T* const_iterator;
+
+        SmallVector() : m_size(0), m_capacity(N), m_heap(NULL) {}
+
+        SmallVector(const SmallVector& rhs) : m_size(0), m_capacity(N), m_heap(NULL)
+        {
+            append(rhs);
+        }
+
+        ~SmallVector()
+        {
+            delete [] m_heap;
+        }
+
+        SmallVector& operator=(const SmallVector& rhs)
+        {
+            if (this != &rhs) {
+                clear();
+                append(rhs);
+            }
+
+            return *this;
+        }
+
+        // keeps any allocated storage for reuse
+        void clear() { m_size = 0; }
+
+        void push_back(const T& v)
+        {
+            if (m_size == m_capacity) {
+                grow(m_capacity * 2);
+            }
+
+            data()[m_size++] = v;
+        }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return (m_size == 0); }
+
+        T& operator[](size_t i) { return data()[i]; }
+        const T& operator[](size_t i) const { return data()[i]; }
+
+        T& front() { return data()[0]; }
+        const T& front() const { return data()[0]; }
+        T& back() { return data()[m_size - 1]; }
+        const T& back() const { return data()[m_size - 1]; }
+
+        T* data() { return (m_heap ? m_heap : m_inline); }
+        const T* data() const { return (m_heap ? m_heap : m_inline); }
+
+        iterator begin() { return data(); }
+        iterator end() { return data() + m_size; }
+        const_iterator begin() const { return data(); }
+        const_iterator end() const { return data() + m_size; }
+
+    private:
+        unsigned int m_size;
+        unsigned int m_capacity;
+
+        // once the inline elements are outgrown every element lives here
+        T* m_heap;
+        T m_inline[N];
+
+        void append(const SmallVector& rhs)
+        {
+            if (rhs.m_size > m_capacity) {
+                grow(rhs.m_size);
+            }
+
+            for (unsigned int i = 0; i < rhs.m_size; i++) {
+                data()[i] = rhs.data()[i];
+            }
+
+            m_size = rhs.m_size;
+        }
+
+        void grow(unsigned int capacity)
+        {
+            T* heap = new T[capacity];
+
+            for (unsigned int i = 0; i < m_size; i++) {
+                heap[i] = data()[i];
+            }
+
+            delete [] m_heap;
+
+            m_heap = heap;
+            m_capacity = capacity;
+        }
+    };
+}
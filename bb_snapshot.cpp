@@ -0,0 +1,954 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "bb_snapshot.h"
+#include "baseball.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+
+#include <string.h>
+#include <vector>
+
+namespace Baseball {
+
+    // "SABR"
+    const unsigned int Snapshot::MAGIC = 0x53414252;
+
+    const unsigned int Snapshot::VERSION = 8;
+
+    namespace {
+
+        // marks a NULL state link
+        const quint32 NO_STATE = 0xffffffff;
+
+        ///////////////////////////////////////////////////////////////////////
+        // primitive values
+
+        template<typename E>
+        void writeEnum(QDataStream& s, const E& e) { s << static_cast<qint32>(e); }
+
+        template<typename E>
+        void readEnum(QDataStream& s, E& e)
+        {
+            qint32 v = 0;
+            s >> v;
+            e = static_cast<E>(v);
+        }
+
+        void write(QDataStream& s, const std::string& sz)
+        {
+            s << QByteArray(sz.data(), static_cast<int>(sz.size()));
+        }
+
+        void read(QDataStream& s, std::string& sz)
+        {
+            QByteArray b;
+            s >> b;
+            sz.assign(b.constData(), b.size());
+        }
+
+        // only the characters of a tag are stored, the type is given by the
+        // tag being read into
+        void write(QDataStream& s, const tag& t)
+        {
+            s.writeRawData(t.ref, TAGLEN - 1);
+        }
+
+        void read(QDataStream& s, tag& t)
+        {
+            char ref[TAGLEN];
+
+            memset(ref, ' ', TAGLEN);
+            s.readRawData(ref, TAGLEN - 1);
+            t.set(ref, TAGLEN - 1);
+        }
+
+        void write(QDataStream& s, const Stat::Bin& b) { s << static_cast<quint32>(b.value); }
+
+        void read(QDataStream& s, Stat::Bin& b)
+        {
+            quint32 v = 0;
+            s >> v;
+            b.value = v;
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // statistics
+
+        // writes or reads each bin of a stat group, in schema order
+        struct WriteBin
+        {
+            WriteBin(QDataStream& st) : s(st) {}
+
+            void operator()(Stat::Id, const char*, const Stat::Bin& b) { write(s, b); }
+
+            QDataStream& s;
+        };
+
+        struct ReadBin
+        {
+            ReadBin(QDataStream& st) : s(st) {}
+
+            void operator()(Stat::Id, const char*, Stat::Bin& b) { read(s, b); }
+
+            QDataStream& s;
+        };
+
+        void write(QDataStream& s, const Player::Record::TeamYear& k)
+        {
+            writeEnum(s, k.type);
+            s << static_cast<qint32>(k.yr);
+            write(s, k.tm);
+        }
+
+        Player::Record::TeamYear readTeamYear(QDataStream& s)
+        {
+            qint32 type = 0, yr = 0;
+            team_tag tm;
+
+            s >> type >> yr;
+            read(s, tm);
+
+            Player::Record::TeamYear k(yr, tm);
+
+            switch (type) {
+            case Player::Record::TeamYear::TEAM:
+                k.type = Player::Record::TeamYear::TEAM;
+                break;
+            case Player::Record::TeamYear::TEAMYEAR:
+                k.type = Player::Record::TeamYear::TEAMYEAR;
+                break;
+            default:
+                k.type = Player::Record::TeamYear::YEAR;
+                break;
+            }
+
+            return k;
+        }
+
+        // the statistics of one year of a player
+        void writeStats(QDataStream& s, const Player::Record::Year& y)
+        {
+            WriteBin w(s);
+
+            y.each(w);
+        }
+
+        void readStats(QDataStream& s, Player::Record::Year& y)
+        {
+            ReadBin r(s);
+
+            y.each(r);
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // play data
+
+        void write(QDataStream& s, const PositionRef& p)
+        {
+            writeEnum(s, p.position);
+            write(s, p.tag);
+        }
+
+        void read(QDataStream& s, PositionRef& p)
+        {
+            readEnum(s, p.position);
+            read(s, p.tag);
+        }
+
+        void write(QDataStream& s, const PositionRefList& l)
+        {
+            s << static_cast<quint32>(l.size());
+
+            for (PositionRefList::const_iterator it = l.begin(); it != l.end(); it++) {
+                write(s, *it);
+            }
+        }
+
+        void read(QDataStream& s, PositionRefList& l)
+        {
+            quint32 n = 0;
+            s >> n;
+
+            l.clear();
+
+            for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+                PositionRef p;
+                read(s, p);
+                l.push_back(p);
+            }
+        }
+
+        void write(QDataStream& s, const Event& e)
+        {
+            writeEnum(s, e.type);
+
+            s << static_cast<quint32>(e.outs.size());
+
+            for (Outs::const_iterator it = e.outs.begin(); it != e.outs.end(); it++) {
+                s << it->tagOut << it->unassisted;
+                writeEnum(s, it->base);
+                write(s, it->out);
+                write(s, it->assists);
+            }
+
+            s << e.advance.error << e.advance.stolen;
+
+            for (int b = Batter; b <= Third; b++) {
+                writeEnum(s, e.advance[static_cast<Base>(b)]);
+            }
+
+            s << static_cast<quint32>(e.runsScored);
+        }
+
+        void read(QDataStream& s, Event& e)
+        {
+            quint32 n = 0;
+
+            readEnum(s, e.type);
+
+            s >> n;
+
+            e.outs.clear();
+
+            for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+                Out o;
+
+                s >> o.tagOut >> o.unassisted;
+                readEnum(s, o.base);
+                read(s, o.out);
+                read(s, o.assists);
+
+                e.outs.push_back(o);
+            }
+
+            s >> e.advance.error >> e.advance.stolen;
+
+            for (int b = Batter; b <= Third; b++) {
+                readEnum(s, e.advance[static_cast<Base>(b)]);
+            }
+
+            s >> n;
+            e.runsScored = n;
+        }
+
+        // maps the index of a state in the StateManager to its position in
+        // the snapshot, removed states are not written
+        typedef std::vector<unsigned int> IndexMap;
+
+        quint32 linkIndex(StateLink l, const IndexMap& indices)
+        {
+            if ((l) && (l->index() < indices.size())) {
+                return indices[l->index()];
+            }
+
+            return NO_STATE;
+        }
+
+        // returns the state for a link read from a snapshot whose first
+        // state was given the index base
+        StateLink linkState(unsigned int base, quint32 idx)
+        {
+            return ((idx == NO_STATE) ? NULL : StateManager::at(base + idx));
+        }
+
+        void write(QDataStream& s, const State& st, const IndexMap& indices)
+        {
+            writeEnum(s, st.type);
+            write(s, st.event);
+            write(s, st.batter);
+            write(s, st.pitcher);
+
+            // pitches are written packed, one byte each
+            s << static_cast<quint32>(st.pitches.size());
+            s.writeRawData(reinterpret_cast<const char*>(st.pitches.data()),
+                           static_cast<int>(st.pitches.size()));
+
+            write(s, st.baseRunners);
+
+            s << static_cast<quint32>(st.inning)
+              << static_cast<quint32>(st.count.strikes)
+              << static_cast<quint32>(st.count.balls)
+              << st.visiting
+              << static_cast<qint32>(st.runsHome)
+              << static_cast<qint32>(st.runsVisiting);
+
+            write(s, st.game);
+
+            s << linkIndex(st.playerLink, indices) << linkIndex(st.gameLink, indices);
+        }
+
+        // reads a state written by write, the links are returned as indices
+        // relative to the first state in the snapshot
+        void read(QDataStream& s, State& st, quint32& playerLink, quint32& gameLink)
+        {
+            quint32 n = 0, inning = 0, strikes = 0, balls = 0;
+            qint32 home = 0, visiting = 0;
+
+            readEnum(s, st.type);
+            read(s, st.event);
+            read(s, st.batter);
+            read(s, st.pitcher);
+
+            s >> n;
+
+            st.pitches.clear();
+
+            // a count past the end of the file is corrupt, rather than
+            // something to allocate
+            if ((s.status() == QDataStream::Ok) && (n > 0)) {
+                if (n > s.device()->bytesAvailable()) {
+                    s.setStatus(QDataStream::ReadCorruptData);
+                } else if (s.readRawData(reinterpret_cast<char*>(st.pitches.resize(n)),
+                                         static_cast<int>(n)) != static_cast<int>(n)) {
+                    st.pitches.clear();
+                    s.setStatus(QDataStream::ReadPastEnd);
+                }
+            }
+
+            read(s, st.baseRunners);
+
+            s >> inning >> strikes >> balls >> st.visiting >> home >> visiting;
+
+            st.inning = inning;
+            st.count.strikes = strikes;
+            st.count.balls = balls;
+            st.runsHome = home;
+            st.runsVisiting = visiting;
+
+            read(s, st.game);
+
+            s >> playerLink >> gameLink;
+        }
+
+        void write(QDataStream& s, const Game::Instance& inst)
+        {
+            s << inst.baseOut.first << inst.baseOut.second << inst.baseOut.third
+              << static_cast<quint32>(inst.baseOut.outs)
+              << static_cast<quint32>(inst.inning)
+              << static_cast<qint32>(inst.runs);
+        }
+
+        void read(QDataStream& s, Game::Instance& inst)
+        {
+            quint32 outs = 0, inning = 0;
+            qint32 runs = 0;
+
+            s >> inst.baseOut.first >> inst.baseOut.second >> inst.baseOut.third
+              >> outs >> inning >> runs;
+
+            inst.baseOut.outs = outs;
+            inst.inning = inning;
+            inst.runs = runs;
+        }
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // tables
+
+    void Snapshot::saveBallparks(QDataStream& s)
+    {
+        s << static_cast<quint32>(Ballpark::Table::count());
+
+        for (Ballpark::Table::Reference it = Ballpark::Table::begin();
+             it != Ballpark::Table::end(); it.next()) {
+            const Ballpark::Record* r = it.record();
+
+            write(s, r->id());
+            write(s, r->name);
+            write(s, r->nickname);
+            write(s, r->city);
+            write(s, r->state);
+            s << r->opened << r->closed;
+            writeEnum(s, r->league);
+            write(s, r->notes);
+        }
+    }
+
+
+    void Snapshot::savePlayers(QDataStream& s)
+    {
+        s << static_cast<quint32>(Player::Table::count());
+
+        for (Player::Table::Reference it = Player::Table::begin();
+             it != Player::Table::end(); it.next()) {
+            const Player::Record* r = it.record();
+
+            write(s, r->id());
+            write(s, r->firstName);
+            write(s, r->surName);
+            s << r->debut;
+
+            s << static_cast<quint32>(r->m_years.size());
+
+            Player::Record::Years::const_iterator yt = r->m_years.begin();
+
+            for (; yt != r->m_years.end(); yt++) {
+                const Player::Record::TeamYear& k = yt->first;
+                const Player::Record::Year& y = yt->second;
+
+                write(s, k);
+
+                s << y.isNull();
+                write(s, y.team);
+                s << static_cast<quint32>(y.number);
+
+                s << static_cast<quint32>(y.positions.size());
+
+                for (PositionList::const_iterator pt = y.positions.begin();
+                     pt != y.positions.end(); pt++) {
+                    writeEnum(s, *pt);
+                }
+
+                writeEnum(s, y.throws);
+                writeEnum(s, y.bats);
+
+                writeStats(s, y);
+            }
+        }
+    }
+
+
+    void Snapshot::saveTeams(QDataStream& s)
+    {
+        s << static_cast<quint32>(Team::Table::count());
+
+        for (Team::Table::Reference it = Team::Table::begin();
+             it != Team::Table::end(); it.next()) {
+            const Team::Record* r = it.record();
+
+            write(s, r->id());
+            s << r->debut;
+
+            s << static_cast<quint32>(r->m_years.size());
+
+            Team::Record::Years::const_iterator yt = r->m_years.begin();
+
+            for (; yt != r->m_years.end(); yt++) {
+                s << static_cast<qint32>(yt->first);
+                s << yt->second.isNull();
+                write(s, yt->second.location);
+                write(s, yt->second.name);
+                writeEnum(s, yt->second.league);
+            }
+        }
+    }
+
+
+    void Snapshot::saveStates(QDataStream& s, std::vector<unsigned int>& indices)
+    {
+        unsigned int n = StateManager::count();
+        quint32 written = 0;
+
+        indices.assign(n, NO_STATE);
+
+        for (unsigned int i = 0; i < n; i++) {
+            if (StateManager::at(i)) {
+                indices[i] = written++;
+            }
+        }
+
+        s << written;
+
+        for (unsigned int i = 0; i < n; i++) {
+            StateLink st = StateManager::at(i);
+
+            if (st) {
+                write(s, *st, indices);
+            }
+        }
+    }
+
+
+    void Snapshot::saveGames(QDataStream& s, const std::vector<unsigned int>& indices)
+    {
+        s << static_cast<quint32>(Game::Table::count());
+
+        for (Game::Table::Reference it = Game::Table::begin();
+             it != Game::Table::end(); it.next()) {
+            const Game::Record* r = it.record();
+
+            write(s, r->id());
+
+            s << r->startTime << static_cast<qint32>(r->year);
+            writeEnum(s, r->type);
+            writeEnum(s, r->sky);
+            writeEnum(s, r->condition);
+            writeEnum(s, r->precipitation);
+            s << r->temperature;
+            writeEnum(s, r->windDirection);
+            s << r->windSpeed << r->useDH
+              << static_cast<qint32>(r->attendance)
+              << static_cast<qint32>(r->duration)
+              << r->night;
+
+            write(s, r->ballpark);
+            write(s, r->teamHome);
+            write(s, r->teamVisiting);
+            write(s, r->com);
+            write(s, r->pitcherW);
+            write(s, r->pitcherL);
+            write(s, r->pitcherSave);
+
+            s << static_cast<qint32>(r->runsHome)
+              << static_cast<qint32>(r->runsVisited);
+
+            // the lineup is written as its history and rebuilt by replaying
+            // the subs in order
+            const Game::Lineup& l = r->lineup;
+
+            s << static_cast<quint32>(l.m_history.size());
+
+            for (size_t j = 0; j < l.m_history.size(); j++) {
+                const Game::Lineup::Entry& e = l.m_history[j];
+
+                write(s, l.m_players[e.player]);
+                writeEnum(s, static_cast<Position>(e.position));
+                s << static_cast<quint32>(e.order);
+                write(s, e.instance);
+                s << e.visiting;
+            }
+
+            s << linkIndex(r->plays, indices);
+
+            s << r->source.fileName << r->source.offset << r->source.length;
+
+            saveStatLog(s, r->stats);
+        }
+    }
+
+
+    void Snapshot::saveManifest(QDataStream& s)
+    {
+        const Manifest::Entries& entries = Manifest::entries();
+        const QList<int>& years = Manifest::years();
+
+        s << static_cast<quint32>(years.size());
+
+        for (int i = 0; i < years.size(); i++) {
+            s << static_cast<qint32>(years.at(i));
+        }
+
+        s << static_cast<quint32>(entries.size());
+
+        for (Manifest::Entries::const_iterator it = entries.begin();
+             it != entries.end(); it++) {
+            const Manifest::Entry* e = it->second;
+
+            s << it->first << e->size << e->modified << e->hash;
+
+            s << static_cast<quint32>(e->games.size());
+
+            for (unsigned int i = 0; i < e->games.size(); i++) {
+                write(s, e->games[i]);
+            }
+        }
+    }
+
+
+    void Snapshot::saveStatLog(QDataStream& s, const StatLog& l)
+    {
+        s << static_cast<quint32>(l.m_players.size());
+
+        for (unsigned int i = 0; i < l.m_players.size(); i++) {
+            write(s, l.m_players[i]);
+        }
+
+        s << static_cast<quint32>(l.m_teams.size());
+
+        for (unsigned int i = 0; i < l.m_teams.size(); i++) {
+            write(s, l.m_teams[i]);
+        }
+
+        s << static_cast<quint32>(l.m_deltas.size());
+
+        for (unsigned int i = 0; i < l.m_deltas.size(); i++) {
+            const StatLog::Delta& d = l.m_deltas[i];
+
+            s << d.player << d.team << d.stat << d.count;
+        }
+    }
+
+
+    void Snapshot::loadBallparks(QDataStream& s)
+    {
+        quint32 n = 0;
+        s >> n;
+
+        for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+            ballpark_tag t;
+            read(s, t);
+
+            Ballpark::Record* r = Ballpark::Table::createRecord(t);
+
+            read(s, r->name);
+            read(s, r->nickname);
+            read(s, r->city);
+            read(s, r->state);
+            s >> r->opened >> r->closed;
+            readEnum(s, r->league);
+            read(s, r->notes);
+        }
+    }
+
+
+    void Snapshot::loadPlayers(QDataStream& s)
+    {
+        quint32 n = 0;
+        s >> n;
+
+        for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+            player_tag t;
+            read(s, t);
+
+            Player::Record* r = Player::Table::createRecord(t);
+            quint32 years = 0;
+
+            read(s, r->firstName);
+            read(s, r->surName);
+            s >> r->debut;
+
+            s >> years;
+
+            for (quint32 j = 0; (j < years) && (s.status() == QDataStream::Ok); j++) {
+                bool null = true;
+                quint32 number = 0, positions = 0;
+
+                Player::Record::Year& y = r->year(readTeamYear(s));
+
+                s >> null;
+                if (!null) y.validate();
+
+                read(s, y.team);
+                s >> number;
+                y.number = number;
+
+                s >> positions;
+
+                y.positions.clear();
+
+                for (quint32 p = 0; (p < positions) && (s.status() == QDataStream::Ok); p++) {
+                    Position pos;
+                    readEnum(s, pos);
+                    y.positions.push_back(pos);
+                }
+
+                readEnum(s, y.throws);
+                readEnum(s, y.bats);
+
+                readStats(s, y);
+            }
+        }
+    }
+
+
+    void Snapshot::loadTeams(QDataStream& s)
+    {
+        quint32 n = 0;
+        s >> n;
+
+        for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+            team_tag t;
+            read(s, t);
+
+            Team::Record* r = Team::Table::createRecord(t);
+            quint32 years = 0;
+
+            s >> r->debut;
+            s >> years;
+
+            for (quint32 j = 0; (j < years) && (s.status() == QDataStream::Ok); j++) {
+                qint32 yr = 0;
+                bool null = true;
+
+                s >> yr;
+
+                Team::Record::Year& y = r->m_years[yr];
+
+                s >> null;
+                if (!null) y.validate();
+
+                read(s, y.location);
+                read(s, y.name);
+                readEnum(s, y.league);
+            }
+        }
+    }
+
+    // states are created first and linked once all of them exist, since
+    // links may point forward.  Returns the index of the first state
+    // read.
+    unsigned int Snapshot::loadStates(QDataStream& s)
+    {
+        unsigned int base = StateManager::count();
+        quint32 n = 0;
+        std::vector<quint32> links;
+
+        s >> n;
+
+        links.reserve(n * 2);
+
+        for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+            StateLink st = StateManager::createState();
+            quint32 playerLink = NO_STATE, gameLink = NO_STATE;
+
+            read(s, *st, playerLink, gameLink);
+
+            links.push_back(playerLink);
+            links.push_back(gameLink);
+        }
+
+        for (unsigned int i = 0; i < (links.size() / 2); i++) {
+            StateLink st = StateManager::at(base + i);
+
+            st->playerLink = linkState(base, links[i * 2]);
+            st->gameLink = linkState(base, links[i * 2 + 1]);
+        }
+
+        return base;
+    }
+
+
+    void Snapshot::loadGames(QDataStream& s, unsigned int base)
+    {
+        quint32 n = 0;
+        s >> n;
+
+        for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+            game_tag t;
+            read(s, t);
+
+            Game::Record* r = Game::Table::createRecord(t);
+            qint32 year = 0, attendance = 0, duration = 0, home = 0, visited = 0;
+            quint32 cards = 0, plays = NO_STATE;
+
+            s >> r->startTime >> year;
+            readEnum(s, r->type);
+            readEnum(s, r->sky);
+            readEnum(s, r->condition);
+            readEnum(s, r->precipitation);
+            s >> r->temperature;
+            readEnum(s, r->windDirection);
+            s >> r->windSpeed >> r->useDH >> attendance >> duration >> r->night;
+
+            r->year = year;
+            r->attendance = attendance;
+            r->duration = duration;
+
+            read(s, r->ballpark);
+            read(s, r->teamHome);
+            read(s, r->teamVisiting);
+            read(s, r->com);
+            read(s, r->pitcherW);
+            read(s, r->pitcherL);
+            read(s, r->pitcherSave);
+
+            s >> home >> visited;
+
+            r->runsHome = home;
+            r->runsVisited = visited;
+
+            s >> cards;
+
+            for (quint32 j = 0; (j < cards) && (s.status() == QDataStream::Ok); j++) {
+                player_tag pt;
+                Game::Lineup::Card c;
+                quint32 order = 0;
+
+                read(s, pt);
+                readEnum(s, c.position);
+                s >> order;
+                read(s, c.instance);
+                s >> c.visiting;
+
+                r->lineup.sub(pt, c.instance, c.position, order, c.visiting);
+            }
+
+            s >> plays;
+
+            r->plays = linkState(base, plays);
+
+            s >> r->source.fileName >> r->source.offset >> r->source.length;
+
+            loadStatLog(s, r->stats);
+        }
+    }
+
+
+    void Snapshot::loadManifest(QDataStream& s)
+    {
+        QList<int> years;
+        quint32 n = 0;
+
+        Manifest::clear();
+
+        s >> n;
+
+        for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+            qint32 yr = 0;
+
+            s >> yr;
+            years.push_back(yr);
+        }
+
+        Manifest::setYears(years);
+
+        s >> n;
+
+        for (quint32 i = 0; (i < n) && (s.status() == QDataStream::Ok); i++) {
+            QString path;
+            quint32 games = 0;
+
+            s >> path;
+
+            Manifest::Entry* e = Manifest::add(path);
+
+            s >> e->size >> e->modified >> e->hash;
+
+            s >> games;
+
+            for (quint32 j = 0; (j < games) && (s.status() == QDataStream::Ok); j++) {
+                game_tag t;
+                read(s, t);
+                e->games.push_back(t);
+            }
+        }
+    }
+
+
+    void Snapshot::loadStatLog(QDataStream& s, StatLog& l)
+    {
+        quint32 players = 0, teams = 0, deltas = 0;
+
+        l.clear();
+
+        s >> players;
+
+        for (quint32 i = 0; (i < players) && (s.status() == QDataStream::Ok); i++) {
+            player_tag t;
+            read(s, t);
+            l.m_players.push_back(t);
+        }
+
+        s >> teams;
+
+        for (quint32 i = 0; (i < teams) && (s.status() == QDataStream::Ok); i++) {
+            l.m_teams.push_back(readTeamYear(s));
+        }
+
+        s >> deltas;
+
+        for (quint32 i = 0; (i < deltas) && (s.status() == QDataStream::Ok); i++) {
+            StatLog::Delta d;
+
+            s >> d.player >> d.team >> d.stat >> d.count;
+
+            // a statistic outside the schema would be applied to nothing
+            if (d.stat > StatLog::APPEARED) {
+                s.setStatus(QDataStream::ReadCorruptData);
+                break;
+            }
+
+            l.m_deltas.push_back(d);
+        }
+    }
+
+    void Snapshot::clear()
+    {
+        // the cache drops the plays of the games it loaded, so it goes
+        // before the games
+        Game::Cache::clear();
+        Manifest::clear();
+        Game::Table::clear();
+        StateManager::clear();
+        Team::Table::clear();
+        Player::Table::clear();
+        Ballpark::Table::clear();
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+
+    bool Snapshot::save(const QString& fileName)
+    {
+        QSaveFile f(fileName);
+
+        if (!f.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+
+        QDataStream s(&f);
+
+        s.setVersion(QDataStream::Qt_5_2);
+
+        s << static_cast<quint32>(MAGIC) << static_cast<quint32>(VERSION);
+
+        saveBallparks(s);
+        savePlayers(s);
+        saveTeams(s);
+        std::vector<unsigned int> indices;
+
+        saveStates(s, indices);
+        saveGames(s, indices);
+        saveManifest(s);
+
+        if (s.status() != QDataStream::Ok) {
+            f.cancelWriting();
+            return false;
+        }
+
+        return f.commit();
+    }
+
+    bool Snapshot::load(const QString& fileName)
+    {
+        QFile f(fileName);
+        quint32 magic = 0, version = 0;
+
+        clear();
+
+        if (!f.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+
+        QDataStream s(&f);
+
+        s.setVersion(QDataStream::Qt_5_2);
+
+        s >> magic >> version;
+
+        if ((magic != MAGIC) || (version != VERSION)) {
+            return false;
+        }
+
+        loadBallparks(s);
+        loadPlayers(s);
+        loadTeams(s);
+        loadGames(s, loadStates(s));
+        loadManifest(s);
+
+        if (s.status() != QDataStream::Ok) {
+            clear();
+            return false;
+        }
+
+        return true;
+    }
+}
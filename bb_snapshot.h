@@ -0,0 +1,79 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QString>
+
+#include <vector>
+
+class QDataStream;
+
+namespace Baseball {
+
+    class StatLog;
+
+    // A snapshot is a binary image of every table (ballparks, players,
+    // teams, games), of the state chains owned by the StateManager, and of
+    // the manifest of the source files they were built from.  It is written
+    // after a parse so that the same database can be opened again without
+    // parsing any of the source files.
+    //
+    // The file starts with a magic number and a format version, a snapshot
+    // written with any other version is rejected and must be rebuilt.
+    class Snapshot
+    {
+    public:
+
+        static const unsigned int MAGIC;
+        static const unsigned int VERSION;
+
+        // writes the current tables to fileName, returns false on error.
+        // The file is replaced only if the whole snapshot was written.
+        static bool save(const QString& fileName);
+
+        // replaces the tables with those read from fileName.  The tables
+        // are left empty if the snapshot could not be read.
+        static bool load(const QString& fileName);
+
+    private:
+
+        static void saveBallparks(QDataStream& s);
+        static void savePlayers(QDataStream& s);
+        static void saveTeams(QDataStream& s);
+        // removed states are skipped, indices maps each state index to its
+        // position in the snapshot
+        static void saveStates(QDataStream& s, std::vector<unsigned int>& indices);
+        static void saveGames(QDataStream& s, const std::vector<unsigned int>& indices);
+        static void saveManifest(QDataStream& s);
+        static void saveStatLog(QDataStream& s, const StatLog& l);
+
+        static void loadBallparks(QDataStream& s);
+        static void loadPlayers(QDataStream& s);
+        static void loadTeams(QDataStream& s);
+        // returns the index given to the first state read
+        static unsigned int loadStates(QDataStream& s);
+        static void loadGames(QDataStream& s, unsigned int base);
+        static void loadManifest(QDataStream& s);
+        static void loadStatLog(QDataStream& s, StatLog& l);
+
+        // empties every table a snapshot is loaded into
+        static void clear();
+    };
+}
@@ -19,12 +19,54 @@
  */
 #include "bb_stat.h"
 
+#include <QtGlobal>
+
 #include <sstream>
 #include <iomanip>
 
 namespace Baseball {
     namespace Stat {
 
+        // A print list has to name every statistic of its group once.  The
+        // count and the sum of the Ids catch a statistic which is missing
+        // from the list, or listed in place of another.
+#       define STAT_COUNT(G, M, L)         + 1
+#       define STAT_SUM(G, M, L)           + G##M
+#       define STAT_PRINT_COUNT(G, M)      + 1
+#       define STAT_PRINT_SUM(G, M)        + G##M
+
+        Q_STATIC_ASSERT_X((0 STAT_BATTING(STAT_COUNT)) == (0 STAT_BATTING_PRINT(STAT_PRINT_COUNT)) &&
+                          (0 STAT_BATTING(STAT_SUM)) == (0 STAT_BATTING_PRINT(STAT_PRINT_SUM)),
+                          "STAT_BATTING_PRINT does not list every batting statistic");
+        Q_STATIC_ASSERT_X((0 STAT_FIELDING(STAT_COUNT)) == (0 STAT_FIELDING_PRINT(STAT_PRINT_COUNT)) &&
+                          (0 STAT_FIELDING(STAT_SUM)) == (0 STAT_FIELDING_PRINT(STAT_PRINT_SUM)),
+                          "STAT_FIELDING_PRINT does not list every fielding statistic");
+
+#       undef STAT_COUNT
+#       undef STAT_SUM
+#       undef STAT_PRINT_COUNT
+#       undef STAT_PRINT_SUM
+
+        const char* label(Id id)
+        {
+#           define LABEL_CASE(G, M, L)         case G##M: return L;
+
+            switch (id) {
+            STAT_BATTING(LABEL_CASE)
+            STAT_FIELDING(LABEL_CASE)
+            STAT_PITCHING(LABEL_CASE)
+            STAT_BASERUNNING(LABEL_CASE)
+            STAT_GENERAL(LABEL_CASE)
+            case NUM_IDS:
+                break;
+            }
+
+#           undef LABEL_CASE
+
+            return "";
+        }
+
+
         Bin& Bin::operator++()
         {
             value++;
@@ -211,11 +253,7 @@ namespace Baseball {
         //                                                                   //
         ///////////////////////////////////////////////////////////////////////
 
-        Batting::Batting() :
-            H1B(0), H2B(0), GDR(0), H3B(0), HR(0), RBI(0),
-            HBP(0), K(0), BB(0), IBB(0),
-            SF(0), SH(0), FC(0), DP(0), RBOE(0), INT(0),
-            AB(0), PA(0)
+        Batting::Batting()
         {
         }
 
@@ -237,35 +275,130 @@ namespace Baseball {
 
         Metric Batting::SLG() const
         {
-            Metric n = MTR(H1B) + MTR(2 * H2B) + MTR(3 + H3B) + MTR(4 + HR);
+            Metric n = MTR(H1B) + MTR(2 * H2B) + MTR(2 * GDR) + MTR(3 * H3B) + MTR(4 * HR);
             Bin d = AB;
 
             return n / MTR(d);
         }
 
 
-        Fielding::Fielding() :
-            A(0), E(0), PO(0)
+        Batting& Batting::operator+=(const Batting& rhs)
+        {
+            if (this != &rhs) {
+                STAT_BATTING(STAT_ADD)
+            }
+
+            return *this;
+        }
+
+
+        Batting& Batting::operator-=(const Batting& rhs)
+        {
+            if (this != &rhs) {
+                STAT_BATTING(STAT_SUB)
+            }
+
+            return *this;
+        }
+
+
+        Fielding::Fielding()
+        {
+        }
+
+
+        Fielding& Fielding::operator+=(const Fielding& rhs)
+        {
+            if (this != &rhs) {
+                STAT_FIELDING(STAT_ADD)
+            }
+
+            return *this;
+        }
+
+
+        Fielding& Fielding::operator-=(const Fielding& rhs)
         {
+            if (this != &rhs) {
+                STAT_FIELDING(STAT_SUB)
+            }
+
+            return *this;
         }
 
 
-        Pitching::Pitching() :
-            IP(0), H(0), R(0), ER(0), BB(0), SO(0), WP(0),
-            W(0), L(0), SV(0)
+        Pitching::Pitching()
         {
         }
 
 
-        BaseRunning::BaseRunning() :
-            SB(0), CS(0)
+        Pitching& Pitching::operator+=(const Pitching& rhs)
         {
+            if (this != &rhs) {
+                STAT_PITCHING(STAT_ADD)
+            }
+
+            return *this;
         }
 
 
-        General::General() :
-            GS(0), GP(0)
+        Pitching& Pitching::operator-=(const Pitching& rhs)
         {
+            if (this != &rhs) {
+                STAT_PITCHING(STAT_SUB)
+            }
+
+            return *this;
+        }
+
+
+        BaseRunning::BaseRunning()
+        {
+        }
+
+
+        BaseRunning& BaseRunning::operator+=(const BaseRunning& rhs)
+        {
+            if (this != &rhs) {
+                STAT_BASERUNNING(STAT_ADD)
+            }
+
+            return *this;
+        }
+
+
+        BaseRunning& BaseRunning::operator-=(const BaseRunning& rhs)
+        {
+            if (this != &rhs) {
+                STAT_BASERUNNING(STAT_SUB)
+            }
+
+            return *this;
+        }
+
+
+        General::General()
+        {
+        }
+
+
+        General& General::operator+=(const General& rhs)
+        {
+            if (this != &rhs) {
+                STAT_GENERAL(STAT_ADD)
+            }
+
+            return *this;
+        }
+
+
+        General& General::operator-=(const General& rhs)
+        {
+            if (this != &rhs) {
+                STAT_GENERAL(STAT_SUB)
+            }
+
+            return *this;
         }
 
         ///////////////////////////////////////////////////////////////////////
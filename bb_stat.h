@@ -36,6 +36,114 @@ namespace Baseball {
             CatGeneral
         };
 
+        // The stat schema.  Each group lists its counting statistics as
+        // X(group, stat, label), and the Id enum, the members of the groups,
+        // their arithmetic, Year::stat, printing and snapshots are generated
+        // from these lists.  A new statistic is added here, and to the print
+        // list of its group below if there is one.  Ids are numbered in list
+        // order across all of the groups and are stored in snapshots, so
+        // adding, removing or moving any statistic renumbers the Ids after
+        // it and Snapshot::VERSION has to be bumped.
+#       define STAT_BATTING(X) \
+            X(Batting, H1B,  "1B")      /* single */ \
+            X(Batting, H2B,  "2B")      /* double */ \
+            X(Batting, GDR,  "GDR")     /* ground rule double */ \
+            X(Batting, H3B,  "3B")      /* triple */ \
+            X(Batting, HR,   "HR")      /* home run */ \
+            X(Batting, RBI,  "RBI")     /* runs batted in */ \
+            X(Batting, HBP,  "HBP")     /* hit by pitch */ \
+            X(Batting, K,    "K")       /* strikeout */ \
+            X(Batting, BB,   "BB")      /* walk */ \
+            X(Batting, IBB,  "IBB")     /* intentional walk */ \
+            X(Batting, SF,   "SF")      /* sacrifice fly */ \
+            X(Batting, SH,   "SH")      /* sacrifice hit */ \
+            X(Batting, FC,   "FC")      /* fielder's choice */ \
+            X(Batting, DP,   "DP")      /* double play */ \
+            X(Batting, RBOE, "RBOE")    /* reached base on error */ \
+            X(Batting, INT,  "INT")     /* interference */ \
+            X(Batting, AB,   "AB")      /* at bats */ \
+            X(Batting, PA,   "PA")      /* plate appearences */
+
+#       define STAT_FIELDING(X) \
+            X(Fielding, A,  "A")        /* assists */ \
+            X(Fielding, E,  "E")        /* errors */ \
+            X(Fielding, PO, "PO")       /* put outs */
+
+#       define STAT_PITCHING(X) \
+            X(Pitching, IP,  "IP")      /* innings pitched (x3 outs) */ \
+            X(Pitching, H,   "H")       /* hits */ \
+            X(Pitching, R,   "R")       /* runs */ \
+            X(Pitching, ER,  "ER")      /* earned runs */ \
+            X(Pitching, BB,  "BB")      /* base on balls */ \
+            X(Pitching, SO,  "SO")      /* strike outs */ \
+            X(Pitching, WP,  "WP")      /* wild pitch */ \
+            X(Pitching, W,   "W")       /* wins */ \
+            X(Pitching, L,   "L")       /* losses */ \
+            X(Pitching, SV,  "SV")      /* saves */ \
+            X(Pitching, BFP, "BFP")     /* batters faced by pitcher */
+
+#       define STAT_BASERUNNING(X) \
+            X(BaseRunning, SB, "SB")    /* stolen bases */ \
+            X(BaseRunning, CS, "CS")    /* caught stealing */
+
+#       define STAT_GENERAL(X) \
+            X(General, GS, "GS")        /* games started */ \
+            X(General, GP, "GP")        /* games played */
+
+        // The order columns are printed in, which is kept apart from the
+        // schema order so that the Ids do not decide the layout of a table.
+        // These lists name the statistics only, the labels come from the
+        // schema, and bb_stat.cpp checks that each one names every
+        // statistic of its group.  Groups without a list print in schema
+        // order.
+#       define STAT_BATTING_PRINT(P) \
+            P(Batting, PA) \
+            P(Batting, AB) \
+            P(Batting, H1B) \
+            P(Batting, H2B) \
+            P(Batting, GDR) \
+            P(Batting, H3B) \
+            P(Batting, HR) \
+            P(Batting, RBI) \
+            P(Batting, HBP) \
+            P(Batting, K) \
+            P(Batting, BB) \
+            P(Batting, IBB) \
+            P(Batting, SF) \
+            P(Batting, SH) \
+            P(Batting, FC) \
+            P(Batting, DP) \
+            P(Batting, RBOE) \
+            P(Batting, INT)
+
+#       define STAT_FIELDING_PRINT(P) \
+            P(Fielding, PO) \
+            P(Fielding, A) \
+            P(Fielding, E)
+
+#       define STAT_ID(G, M, L)        G##M,
+#       define STAT_MEMBER(G, M, L)    Bin M;
+#       define STAT_EACH(G, M, L)      f(G##M, L, M);
+#       define STAT_PRINT_EACH(G, M)   f(G##M, label(G##M), M);
+#       define STAT_ADD(G, M, L)       M += rhs.M;
+#       define STAT_SUB(G, M, L)       M -= rhs.M;
+
+        // Identifies a single counting statistic, one for every Bin of the
+        // stat groups below
+        enum Id
+        {
+            STAT_BATTING(STAT_ID)
+            STAT_FIELDING(STAT_ID)
+            STAT_PITCHING(STAT_ID)
+            STAT_BASERUNNING(STAT_ID)
+            STAT_GENERAL(STAT_ID)
+
+            NUM_IDS
+        };
+
+        // the label of a statistic, as given in the schema
+        const char* label(Id id);
+
         typedef double Metric;
 
 #       define MTR(x) ((Metric)(x.value))
@@ -142,27 +250,7 @@ namespace Baseball {
         {
             Batting();
 
-            Bin H1B;   // single
-            Bin H2B;   // double
-            Bin GDR;   // ground rule double
-            Bin H3B;   // triple
-            Bin HR;    // HR
-            Bin RBI;   // RBIs
-
-            Bin HBP;   // hit by pitch
-            Bin K;     // strikeout
-            Bin BB;    // walk
-            Bin IBB;   // intentional walk
-
-            Bin SF;    // sacrifice fly
-            Bin SH;    // sacrifice hit
-            Bin FC;    // fielder's choice
-            Bin DP;    // double play
-            Bin RBOE;  // reached base on error
-            Bin INT;   // interference
-
-            Bin AB;    // at bats
-            Bin PA;    // plate appearences
+            STAT_BATTING(STAT_MEMBER)
 
             // computed stats
             Bin H() const;
@@ -171,50 +259,71 @@ namespace Baseball {
             Metric OBP() const;
             Metric SLG() const;
 
+            // calls f(id, label, bin) for each statistic in schema order
+            template<typename F> void each(F& f) { STAT_BATTING(STAT_EACH) }
+            template<typename F> void each(F& f) const { STAT_BATTING(STAT_EACH) }
+
+            // the same, in print order
+            template<typename F> void eachPrinted(F& f) const { STAT_BATTING_PRINT(STAT_PRINT_EACH) }
+
+            Batting& operator+=(const Batting& rhs);
+            Batting& operator-=(const Batting& rhs);
         };
 
         struct Fielding
         {
             Fielding();
 
-            Bin A;     // assists
-            Bin E;     // errors
-            Bin PO;    // put outs
+            STAT_FIELDING(STAT_MEMBER)
+
+            template<typename F> void each(F& f) { STAT_FIELDING(STAT_EACH) }
+            template<typename F> void each(F& f) const { STAT_FIELDING(STAT_EACH) }
+            template<typename F> void eachPrinted(F& f) const { STAT_FIELDING_PRINT(STAT_PRINT_EACH) }
+
+            Fielding& operator+=(const Fielding& rhs);
+            Fielding& operator-=(const Fielding& rhs);
         };
 
         struct Pitching
         {
             Pitching();
 
-            Bin IP;    // innings pitched (x3 outs)
-            Bin H;     // hits
-            Bin R;     // runs
-            Bin ER;    // earned runs
-            Bin BB;    // base on balls
-            Bin SO;    // strike outs
-            Bin WP;    // wild pitch
+            STAT_PITCHING(STAT_MEMBER)
 
-            Bin W;     // wins
-            Bin L;     // losses
-            Bin SV;    // saves
+            template<typename F> void each(F& f) { STAT_PITCHING(STAT_EACH) }
+            template<typename F> void each(F& f) const { STAT_PITCHING(STAT_EACH) }
+            template<typename F> void eachPrinted(F& f) const { STAT_PITCHING(STAT_EACH) }
 
-            Bin BFP;   // batters faced by pitcher
+            Pitching& operator+=(const Pitching& rhs);
+            Pitching& operator-=(const Pitching& rhs);
         };
 
         struct BaseRunning
         {
             BaseRunning();
 
-            Bin SB;    // stolen bases
-            Bin CS;    // caught stealing
+            STAT_BASERUNNING(STAT_MEMBER)
+
+            template<typename F> void each(F& f) { STAT_BASERUNNING(STAT_EACH) }
+            template<typename F> void each(F& f) const { STAT_BASERUNNING(STAT_EACH) }
+            template<typename F> void eachPrinted(F& f) const { STAT_BASERUNNING(STAT_EACH) }
+
+            BaseRunning& operator+=(const BaseRunning& rhs);
+            BaseRunning& operator-=(const BaseRunning& rhs);
         };
 
         struct General
         {
             General();
 
-            Bin GS;    // games started
-            Bin GP;    // games played
+            STAT_GENERAL(STAT_MEMBER)
+
+            template<typename F> void each(F& f) { STAT_GENERAL(STAT_EACH) }
+            template<typename F> void each(F& f) const { STAT_GENERAL(STAT_EACH) }
+            template<typename F> void eachPrinted(F& f) const { STAT_GENERAL(STAT_EACH) }
+
+            General& operator+=(const General& rhs);
+            General& operator-=(const General& rhs);
         };
 
     }
@@ -19,6 +19,8 @@
  */
 #include "bb_state.h"
 
+#include <new>
+
 namespace Baseball {
 
     bool State::endInning() const
@@ -29,43 +31,253 @@ namespace Baseball {
 
     ///////////////////////////////////////////////////////////////////////////
 
-    StateManager::~StateManager()
+    StateArena::~StateArena()
+    {
+        clear();
+    }
+
+
+    StateLink StateArena::create(const State::Type& t)
+    {
+        if (m_used >= m_capacity) {
+            addSlab(SLAB_SIZE);
+        }
+
+        return new (&m_slabs.back().states[m_used++]) State(t);
+    }
+
+
+    void StateArena::reserve(unsigned int n)
+    {
+        if ((n > 0) && ((m_capacity - m_used) < n)) {
+            addSlab(n);
+        }
+    }
+
+
+    void StateArena::addSlab(unsigned int capacity)
+    {
+        Slab s;
+
+        // the slab being replaced keeps the states made in it
+        if (!m_slabs.empty()) {
+            m_slabs.back().count = m_used;
+        }
+
+        s.states = static_cast<State*>(::operator new(sizeof(State) * capacity));
+        s.capacity = capacity;
+        s.count = 0;
+
+        m_slabs.push_back(s);
+        m_used = 0;
+        m_capacity = capacity;
+    }
+
+
+    void StateArena::merge(StateArena& rhs)
+    {
+        if ((this == &rhs) || (rhs.m_slabs.empty())) return;
+
+        rhs.m_slabs.back().count = rhs.m_used;
+
+        // keep filling whichever of the two last slabs has more room left,
+        // the other is closed at the count it reached
+        if ((!m_slabs.empty()) &&
+            ((m_capacity - m_used) >= (rhs.m_capacity - rhs.m_used))) {
+            m_slabs.insert(m_slabs.end() - 1, rhs.m_slabs.begin(), rhs.m_slabs.end());
+        } else {
+            if (!m_slabs.empty()) {
+                m_slabs.back().count = m_used;
+            }
+
+            m_slabs.insert(m_slabs.end(), rhs.m_slabs.begin(), rhs.m_slabs.end());
+            m_used = rhs.m_used;
+            m_capacity = rhs.m_capacity;
+        }
+
+        rhs.m_slabs.clear();
+        rhs.m_used = 0;
+        rhs.m_capacity = 0;
+    }
+
+
+    void StateArena::clear()
     {
-        for (unsigned int i = 0; i < m_states.size(); i++) {
-            delete m_states[i];
+        for (unsigned int i = 0; i < m_slabs.size(); i++) {
+            Slab& s = m_slabs[i];
+            unsigned int n = ((i == (m_slabs.size() - 1)) ? m_used : s.count);
+
+            for (unsigned int j = 0; j < n; j++) {
+                s.states[j].~State();
+            }
+
+            ::operator delete(s.states);
         }
 
+        m_slabs.clear();
+        m_used = 0;
+        m_capacity = 0;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+
+    StateManager::~StateManager()
+    {
+        // the states themselves are destroyed by the arena
         m_states.clear();
     }
 
     StateLink StateManager::createState(const State::Type& t)
     {
-        StateLink s = new State(t);
+        return getInstance()->create(t);
+    }
+
+    StateLink StateManager::create(const State::Type& t)
+    {
+        StateLink s = NULL;
 
-        getInstance()->m_states.push_back(s);
+        if (!m_free.empty()) {
+            unsigned int idx = m_free.back();
+            unsigned int generation;
+
+            m_free.pop_back();
+
+            s = m_states[idx].state;
+            generation = s->m_generation;
+
+            *s = State(t);
+
+            s->m_index = idx;
+            s->m_generation = generation;
+
+            m_states[idx].live = true;
+        } else {
+            Slot slot;
 
-        s->m_index = (getInstance()->m_states.size() - 1);
+            s = m_arena.create(t);
+
+            slot.state = s;
+            slot.live = true;
+
+            m_states.push_back(slot);
+
+            s->m_index = (m_states.size() - 1);
+        }
+
+        m_live++;
 
         return s;
     }
 
-    void StateManager::removeState(unsigned int idx)
+    void StateManager::remove(unsigned int idx)
+    {
+        if ((idx >= m_states.size()) || (!m_states[idx].live)) return;
+
+        StateLink s = m_states[idx].state;
+        unsigned int generation = s->m_generation + 1;
+
+        // release the lists held by the state now rather than on reuse
+        *s = State();
+
+        s->m_index = idx;
+        s->m_generation = generation;
+
+        m_states[idx].live = false;
+        m_free.push_back(idx);
+
+        m_live--;
+    }
+
+    void StateManager::merge(StateManager& rhs)
     {
-        if (idx < getInstance()->m_states.size()) {
-            getInstance()->m_states.erase(
-                getInstance()->m_states.begin() + idx);
+        if (this == &rhs) return;
+
+        unsigned int base = m_states.size();
+
+        m_states.reserve(m_states.size() + rhs.m_states.size());
+
+        for (unsigned int i = 0; i < rhs.m_states.size(); i++) {
+            Slot slot = rhs.m_states[i];
+
+            m_states.push_back(slot);
+            slot.state->m_index = (m_states.size() - 1);
         }
+
+        for (unsigned int i = 0; i < rhs.m_free.size(); i++) {
+            m_free.push_back(base + rhs.m_free[i]);
+        }
+
+        m_live += rhs.m_live;
+
+        rhs.m_states.clear();
+        rhs.m_free.clear();
+        rhs.m_live = 0;
+
+        m_arena.merge(rhs.m_arena);
+    }
+
+    void StateManager::removeState(unsigned int idx)
+    {
+        getInstance()->remove(idx);
     }
 
     void StateManager::removeState(StateLink state)
     {
-        removeState(state->index());
+        if (isValid(state)) {
+            removeState(state->handle());
+        }
+    }
+
+    void StateManager::removeState(const StateHandle& h)
+    {
+        if (isValid(at(h))) {
+            getInstance()->remove(h.index);
+        }
+    }
+
+    void StateManager::clear()
+    {
+        getInstance()->reset();
+    }
+
+    void StateManager::reset()
+    {
+        m_states.clear();
+        m_free.clear();
+        m_live = 0;
+        m_arena.clear();
+    }
+
+    void StateManager::removeChain(StateLink state)
+    {
+        while (isValid(state)) {
+            StateLink next = state->gameLink;
+
+            // stop at a state which was already removed
+            if (at(state->handle()) != state) break;
+
+            removeState(state->index());
+
+            state = next;
+        }
     }
 
     StateLink StateManager::at(unsigned int idx)
     {
-        if (idx < getInstance()->m_states.size()) {
-            return getInstance()->m_states.at(idx);
+        if ((idx < getInstance()->m_states.size()) &&
+            (getInstance()->m_states[idx].live)) {
+            return getInstance()->m_states[idx].state;
+        }
+
+        return NULL;
+    }
+
+    StateLink StateManager::at(const StateHandle& h)
+    {
+        StateLink s = at(h.index);
+
+        if ((isValid(s)) && (s->m_generation == h.generation)) {
+            return s;
         }
 
         return NULL;
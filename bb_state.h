@@ -30,6 +30,8 @@ namespace Baseball {
 	class Event
 	{
 	public:
+        Event() : type(NP), runsScored(0) {}
+
         enum Type {
 			NP = 0,	// no play
             O, // batted ball out
@@ -70,6 +72,29 @@ namespace Baseball {
 
     typedef State* StateLink;
 
+    // A handle to a state owned by the StateManager.  A handle is only
+    // resolved while the state it was taken from exists, a handle to a
+    // removed state is rejected even after its slot has been reused.
+    struct StateHandle
+    {
+        StateHandle() : index(INVALID), generation(0) {}
+        StateHandle(unsigned int i, unsigned int g) : index(i), generation(g) {}
+
+        static const unsigned int INVALID = 0xffffffff;
+
+        unsigned int index;
+        unsigned int generation;
+
+        bool isValid() const { return (index != INVALID); }
+
+        bool operator==(const StateHandle& rhs) const {
+            return ((index == rhs.index) && (generation == rhs.generation));
+        }
+        bool operator!=(const StateHandle& rhs) const {
+            return (false == operator==(rhs));
+        }
+    };
+
 	class State
 	{
         friend class StateManager;
@@ -86,8 +111,12 @@ namespace Baseball {
             SENDGAME,
 		};
 
-        State() : type(SNULL) {}
-        State(const Type& t) : type(t) {}
+        State() :
+            type(SNULL), inning(0), visiting(false), runsHome(0), runsVisiting(0),
+            playerLink(NULL), gameLink(NULL), m_index(0), m_generation(0) {}
+        State(const Type& t) :
+            type(t), inning(0), visiting(false), runsHome(0), runsVisiting(0),
+            playerLink(NULL), gameLink(NULL), m_index(0), m_generation(0) {}
 
     public:
         Type type;
@@ -95,6 +124,8 @@ namespace Baseball {
         Event event;
 
         PositionRef batter;
+        // the pitcher facing the batter
+        PositionRef pitcher;
         Pitches pitches;
 
         PositionRefList baseRunners;
@@ -123,10 +154,14 @@ namespace Baseball {
         int runsScored() const { return runsHome + runsVisiting; }
         bool endInning() const;
         unsigned int index() const { return m_index; }
+        StateHandle handle() const { return StateHandle(m_index, m_generation); }
 
     protected:
 
         unsigned int m_index;
+
+        // incremented each time the slot holding this state is reused
+        unsigned int m_generation;
 	};
 
 
@@ -197,24 +232,132 @@ namespace Baseball {
 
     };
 
+    // Allocates states in slabs.  The states of a game are created one
+    // after another, so they sit next to each other in memory and walking a
+    // game's chain reads memory in order.  States are not freed one at a
+    // time, they are destroyed together with the arena.
+    class StateArena
+    {
+    public:
+        StateArena() : m_used(0), m_capacity(0) {}
+        ~StateArena();
+
+        static const unsigned int SLAB_SIZE = 1024;
+
+        // constructs a new state in the current slab
+        StateLink create(const State::Type& t);
+
+        // makes room for n more states.  If the current slab cannot hold
+        // them, a slab of exactly n states is started, so that an arena
+        // which knows how many states it will hold does not leave most of a
+        // slab unused when it is merged.
+        void reserve(unsigned int n);
+
+        // takes every slab owned by rhs, rhs is left empty.  States keep
+        // their addresses.  New states go on filling whichever last slab
+        // had more room.
+        void merge(StateArena& rhs);
+
+        // destroys every state and frees the slabs
+        void clear();
+
+    protected:
+
+        struct Slab {
+            State* states;
+
+            // number of states the slab has room for
+            unsigned int capacity;
+
+            // states constructed in this slab, unless this is the last slab
+            // in which case m_used is the count
+            unsigned int count;
+        };
+
+        void addSlab(unsigned int capacity);
+
+        std::vector<Slab> m_slabs;
+
+        // number of states used in the last slab
+        unsigned int m_used;
+
+        // capacity of the last slab
+        unsigned int m_capacity;
+
+    private:
+        StateArena(const StateArena&);
+        StateArena& operator=(const StateArena&);
+    };
+
     class StateManager : public Singleton<StateManager>
     {
     public:
 
-        StateManager() {}
+        StateManager() : m_live(0) {}
         ~StateManager();
 
         static StateLink createState(const State::Type& t = State::SNULL);
 
+        // returns the state in slot idx, or NULL if that slot is free
         static StateLink at(unsigned int idx);
+
+        // returns the state h refers to, or NULL if it has been removed
+        static StateLink at(const StateHandle& h);
+
+        // the number of slots, every state index is less than this
         static unsigned int count() { return getInstance()->m_states.size(); }
 
+        // the number of states which have not been removed
+        static unsigned int live() { return getInstance()->m_live; }
+
+        // removing a state frees its slot for reuse in constant time.  Links
+        // to the removed state held by other states are not cleared.
         static void removeState(StateLink state);
         static void removeState(unsigned int idx);
+        static void removeState(const StateHandle& h);
+
+        // removes state and every state following it on its game chain,
+        // this is used to drop a game
+        static void removeChain(StateLink state);
+
+        // destroys every state, the next state created gets index 0
+        static void clear();
+
+        // destroys every state owned by this manager
+        void reset();
+
+        // creates a state owned by this manager.  createState is the same
+        // as calling create on the global instance.
+        StateLink create(const State::Type& t = State::SNULL);
+
+        void remove(unsigned int idx);
+
+        // moves every state owned by rhs onto the end of this manager,
+        // keeping their order and renumbering their indices.  rhs is left
+        // empty.
+        void merge(StateManager& rhs);
+
+        // makes room in the arena for n more states, see StateArena::reserve
+        void reserve(unsigned int n) { m_arena.reserve(n); }
 
     protected:
 
-        std::vector<StateLink> m_states;
+        struct Slot {
+            StateLink state;
+
+            // false once the state has been removed, the state object is
+            // kept and reused by the next state created in this slot
+            bool live;
+        };
+
+        std::vector<Slot> m_states;
+
+        // free slots, most recently freed last
+        std::vector<unsigned int> m_free;
+
+        unsigned int m_live;
+
+        StateArena m_arena;
     };
 
 }
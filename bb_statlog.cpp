@@ -0,0 +1,213 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "bb_statlog.h"
+#include "bb_record.h"
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <algorithm>
+
+namespace Baseball {
+
+    namespace {
+
+        // below this many changes the logs are applied on the calling thread
+        static const size_t MIN_PARALLEL = 65536;
+
+        class Reducer : public QRunnable
+        {
+        public:
+            Reducer(const std::vector<const StatLog*>& logs, bool subtract,
+                    unsigned int part, unsigned int parts) :
+                m_logs(logs), m_subtract(subtract), m_part(part), m_parts(parts) {}
+
+            void run()
+            {
+                for (size_t i = 0; i < m_logs.size(); i++) {
+                    m_logs[i]->apply(m_subtract, m_part, m_parts);
+                }
+            }
+
+        private:
+            const std::vector<const StatLog*>& m_logs;
+            bool m_subtract;
+            unsigned int m_part;
+            unsigned int m_parts;
+        };
+    }
+
+
+    void StatLog::add(const tag& player, const TeamYear& ty, Stat::Id id, unsigned int count)
+    {
+        push(playerIndex(player), teamIndex(ty), static_cast<quint8>(id), count);
+    }
+
+
+    void StatLog::appear(const tag& player, const TeamYear& ty)
+    {
+        push(playerIndex(player), teamIndex(ty), APPEARED, 0);
+    }
+
+
+    void StatLog::add(unsigned int player, unsigned int team, Stat::Id id, unsigned int count)
+    {
+        push(player, team, static_cast<quint8>(id), count);
+    }
+
+
+    void StatLog::appear(unsigned int player, unsigned int team)
+    {
+        push(player, team, APPEARED, 0);
+    }
+
+
+    unsigned int StatLog::playerIndex(const tag& player)
+    {
+        // a game has a few dozen players and two teams at most, so the
+        // indices are found by a plain search
+        size_t p = 0;
+
+        while ((p < m_players.size()) && (m_players[p] != player)) p++;
+
+        if (p == m_players.size()) {
+            m_players.push_back(player);
+        }
+
+        return static_cast<unsigned int>(p);
+    }
+
+
+    unsigned int StatLog::teamIndex(const TeamYear& ty)
+    {
+        size_t t = 0;
+
+        while ((t < m_teams.size()) &&
+               ((m_teams[t] < ty) || (ty < m_teams[t]))) t++;
+
+        if (t == m_teams.size()) {
+            m_teams.push_back(ty);
+        }
+
+        return static_cast<unsigned int>(t);
+    }
+
+
+    void StatLog::push(unsigned int player, unsigned int team, quint8 stat, unsigned int count)
+    {
+        Delta d;
+
+        d.player = static_cast<quint16>(player);
+        d.team = static_cast<quint8>(team);
+        d.stat = stat;
+        d.count = count;
+
+        m_deltas.push_back(d);
+    }
+
+
+    void StatLog::compact()
+    {
+        if (m_deltas.size() < 2) return;
+
+        std::sort(m_deltas.begin(), m_deltas.end());
+
+        size_t n = 0;
+
+        for (size_t i = 1; i < m_deltas.size(); i++) {
+            Delta& last = m_deltas[n];
+
+            if ((last < m_deltas[i]) || (m_deltas[i] < last)) {
+                m_deltas[++n] = m_deltas[i];
+            } else {
+                last.count += m_deltas[i].count;
+            }
+        }
+
+        m_deltas.resize(n + 1);
+    }
+
+
+    void StatLog::clear()
+    {
+        m_players.clear();
+        m_teams.clear();
+        m_deltas.clear();
+    }
+
+
+    void StatLog::apply(bool subtract, unsigned int part, unsigned int parts) const
+    {
+        std::vector<Player::Record*> records(m_players.size(), static_cast<Player::Record*>(0));
+
+        for (size_t i = 0; i < m_players.size(); i++) {
+            if ((parts > 1) && ((tag_hash(m_players[i].key) % parts) != part)) continue;
+
+            records[i] = Player::Table::get(m_players[i]);
+        }
+
+        for (size_t i = 0; i < m_deltas.size(); i++) {
+            const Delta& d = m_deltas[i];
+            Player::Record* r = records[d.player];
+
+            if (!r) continue;
+
+            Player::Record::Year& y = r->year(m_teams[d.team]);
+
+            if (d.stat == APPEARED) {
+                if (!subtract) y.validate();
+            } else if (subtract) {
+                y.stat(static_cast<Stat::Id>(d.stat)) -= d.count;
+            } else {
+                y.stat(static_cast<Stat::Id>(d.stat)) += d.count;
+            }
+        }
+    }
+
+
+    void StatLog::reduce(const std::vector<const StatLog*>& logs, bool subtract)
+    {
+        size_t total = 0;
+        int parts = QThread::idealThreadCount();
+
+        for (size_t i = 0; i < logs.size(); i++) {
+            total += logs[i]->size();
+        }
+
+        if ((parts <= 1) || (total < MIN_PARALLEL)) {
+            for (size_t i = 0; i < logs.size(); i++) {
+                logs[i]->apply(subtract);
+            }
+
+            return;
+        }
+
+        QThreadPool pool;
+
+        pool.setMaxThreadCount(parts);
+
+        for (int i = 0; i < parts; i++) {
+            pool.start(new Reducer(logs, subtract, i, parts));
+        }
+
+        pool.waitForDone();
+    }
+}
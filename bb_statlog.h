@@ -0,0 +1,106 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "bb_defs.h"
+#include "bb_player.h"
+#include "bb_stat.h"
+
+#include <QtGlobal>
+
+#include <vector>
+
+namespace Baseball {
+
+    class Snapshot;
+
+    // A StatLog lists the changes a single game makes to player statistics,
+    // each keyed by player, team/year and statistic, instead of applying them
+    // as the game is parsed.  Logs are folded into the player table later by
+    // reduce, and can be taken back out the same way, so the statistics of
+    // any set of games can be rebuilt without parsing them again.
+    class StatLog
+    {
+        friend class Baseball::Snapshot;
+
+    public:
+        typedef Player::Record::TeamYear TeamYear;
+
+        // adds count to the statistic id of player in the team/year ty
+        void add(const tag& player, const TeamYear& ty, Stat::Id id, unsigned int count = 1);
+
+        // records that player appeared for the team/year ty, which puts ty
+        // on the player's record even if no statistic is added to it
+        void appear(const tag& player, const TeamYear& ty);
+
+        // the same by the indices of a player and a team/year in this log,
+        // for callers which keep them across many changes
+        void add(unsigned int player, unsigned int team, Stat::Id id, unsigned int count = 1);
+        void appear(unsigned int player, unsigned int team);
+
+        // return the index of player or ty in this log, adding it if needed
+        unsigned int playerIndex(const tag& player);
+        unsigned int teamIndex(const TeamYear& ty);
+
+        // merges the changes with the same key, leaving one per key
+        void compact();
+
+        void clear();
+
+        size_t size() const { return m_deltas.size(); }
+        bool isEmpty() const { return m_deltas.empty(); }
+
+        // applies the log to the player table, or takes it back out if
+        // subtract is set.  Only the players whose tag hash falls into
+        // partition part of parts are changed.
+        void apply(bool subtract = false, unsigned int part = 0, unsigned int parts = 1) const;
+
+        // applies every log, splitting the players into one partition per
+        // thread so that no two threads change the same record.  The player
+        // table itself must not change meanwhile.
+        static void reduce(const std::vector<const StatLog*>& logs, bool subtract = false);
+
+    protected:
+
+        // a change for an appearance rather than for a statistic
+        static const quint8 APPEARED = Stat::NUM_IDS;
+
+        struct Delta
+        {
+            quint16 player;   // index into m_players
+            quint8 team;      // index into m_teams
+            quint8 stat;      // Stat::Id or APPEARED
+            quint32 count;
+
+            bool operator<(const Delta& rhs) const {
+                return ((player < rhs.player) ||
+                        ((player == rhs.player) &&
+                         ((team < rhs.team) ||
+                          ((team == rhs.team) && (stat < rhs.stat)))));
+            }
+        };
+
+        void push(unsigned int player, unsigned int team, quint8 stat, unsigned int count);
+
+        std::vector<tag> m_players;
+        std::vector<TeamYear> m_teams;
+        std::vector<Delta> m_deltas;
+    };
+}
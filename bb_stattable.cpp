@@ -0,0 +1,419 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "bb_stattable.h"
+#include "bb_player.h"
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define STAT_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   include <emmintrin.h>
+#   define STAT_SSE2
+#endif
+
+namespace Baseball {
+
+    namespace {
+
+        // one player season while the table is built
+        struct Season
+        {
+            int year;
+            unsigned long long player;
+            unsigned long long team;
+            const Player::Record::Year* stats;
+        };
+
+        // copies each statistic of a season into its column
+        struct SetRow
+        {
+            SetRow(std::vector<quint32>* c, size_t r) : columns(c), row(r) {}
+
+            void operator()(Stat::Id id, const char*, const Stat::Bin& b)
+            {
+                columns[id][row] = b.value;
+            }
+
+            std::vector<quint32>* columns;
+            size_t row;
+        };
+
+        bool seasonBefore(const Season& a, const Season& b)
+        {
+            return (a.year < b.year);
+        }
+
+        // sum of the values of col whose flag in sel is set
+        unsigned long long sumSelected(const quint32* col, const unsigned char* sel, size_t n)
+        {
+            unsigned long long total = 0;
+            size_t i = 0;
+
+#if defined(STAT_AVX2)
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i acc = zero;
+
+            for (; (i + 8) <= n; i += 8) {
+                __m256i f = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(sel + i)));
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i));
+
+                v = _mm256_and_si256(v, _mm256_cmpgt_epi32(f, zero));
+
+                // widen to 64 bits before adding so that totals cannot wrap
+                acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+                acc = _mm256_add_epi64(acc, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+            }
+
+            unsigned long long lanes[4];
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+            total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(STAT_SSE2)
+            const __m128i zero = _mm_setzero_si128();
+            __m128i acc = zero;
+
+            for (; (i + 4) <= n; i += 4) {
+                int flags;
+
+                memcpy(&flags, sel + i, sizeof(flags));
+
+                __m128i f = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(flags), zero), zero);
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(col + i));
+
+                v = _mm_and_si128(v, _mm_cmpgt_epi32(f, zero));
+
+                acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+                acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+            }
+
+            unsigned long long lanes[2];
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+            total = lanes[0] + lanes[1];
+#endif
+
+            for (; i < n; i++) {
+                if (sel[i]) total += col[i];
+            }
+
+            return total;
+        }
+
+        // smallest and largest values of col whose flag in sel is set
+        void extremesSelected(const quint32* col, const unsigned char* sel, size_t n,
+                              quint32& lo, quint32& hi)
+        {
+            size_t i = 0;
+
+            lo = 0xffffffff;
+            hi = 0;
+
+#if defined(STAT_AVX2)
+            // unselected values are replaced by ones that cannot win
+            const __m256i zero = _mm256_setzero_si256();
+            __m256i vlo = _mm256_set1_epi32(-1);
+            __m256i vhi = zero;
+
+            for (; (i + 8) <= n; i += 8) {
+                __m256i f = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(sel + i)));
+                __m256i m = _mm256_cmpgt_epi32(f, zero);
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(col + i));
+
+                vlo = _mm256_min_epu32(vlo, _mm256_or_si256(v, _mm256_andnot_si256(m, _mm256_set1_epi32(-1))));
+                vhi = _mm256_max_epu32(vhi, _mm256_and_si256(v, m));
+            }
+
+            quint32 los[8], his[8];
+
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(los), vlo);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(his), vhi);
+
+            for (int j = 0; j < 8; j++) {
+                lo = std::min(lo, los[j]);
+                hi = std::max(hi, his[j]);
+            }
+#endif
+
+            // SSE2 has no unsigned 32 bit min or max, this loop is left to
+            // the compiler
+            for (; i < n; i++) {
+                if (sel[i]) {
+                    lo = std::min(lo, col[i]);
+                    hi = std::max(hi, col[i]);
+                }
+            }
+        }
+
+        Stat::Metric rate(unsigned long long n, unsigned long long d)
+        {
+            return ((d > 0) ? ((Stat::Metric)n / (Stat::Metric)d) : 0.0);
+        }
+    }
+
+
+    void StatTable::clear()
+    {
+        for (int i = 0; i < Stat::NUM_IDS; i++) {
+            m_columns[i].clear();
+        }
+
+        m_year.clear();
+        m_player.clear();
+        m_team.clear();
+        m_years.clear();
+        m_yearStart.clear();
+    }
+
+
+    void StatTable::build()
+    {
+        StatTable* st = getInstance();
+        std::vector<Season> seasons;
+
+        st->clear();
+
+        for (Player::Table::Reference it = Player::Table::begin();
+             it != Player::Table::end(); it.next()) {
+            const Player::Record* r = it.record();
+            const Player::Record::Years& years = r->m_years;
+
+            for (size_t i = 0; i < years.size(); i++) {
+                if (years[i].first.type != Player::Record::TeamYear::TEAMYEAR) continue;
+
+                Season s;
+
+                s.year = years[i].first.yr;
+                s.player = r->id().key.head;
+                s.team = years[i].first.tm.key.head;
+                s.stats = &years[i].second;
+
+                seasons.push_back(s);
+            }
+        }
+
+        // stable, so the seasons of a year stay in table order
+        std::stable_sort(seasons.begin(), seasons.end(), seasonBefore);
+
+        size_t n = seasons.size();
+
+        st->m_year.resize(n);
+        st->m_player.resize(n);
+        st->m_team.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            const Season& s = seasons[i];
+
+            st->m_year[i] = s.year;
+            st->m_player[i] = s.player;
+            st->m_team[i] = s.team;
+
+            if ((i == 0) || (s.year != seasons[i - 1].year)) {
+                st->m_years.push_back(s.year);
+                st->m_yearStart.push_back(i);
+            }
+        }
+
+        st->m_yearStart.push_back(n);
+
+        for (int id = 0; id < Stat::NUM_IDS; id++) {
+            st->m_columns[id].resize(n);
+        }
+
+        for (size_t i = 0; i < n; i++) {
+            SetRow set(st->m_columns, i);
+
+            seasons[i].stats->each(set);
+        }
+    }
+
+
+    StatTable::Selection StatTable::all()
+    {
+        return Selection(count(), 1);
+    }
+
+
+    const quint32* StatTable::column(Stat::Id id)
+    {
+        return getInstance()->m_columns[id].data();
+    }
+
+
+    void StatTable::whereYear(Selection& sel, int first, int last)
+    {
+        const int* year = getInstance()->m_year.data();
+        size_t n = std::min(sel.size(), count());
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= ((year[i] >= first) && (year[i] <= last));
+        }
+    }
+
+
+    void StatTable::wherePlayer(Selection& sel, const player_tag& t)
+    {
+        const unsigned long long* player = getInstance()->m_player.data();
+        size_t n = std::min(sel.size(), count());
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= (player[i] == t.key.head);
+        }
+    }
+
+
+    void StatTable::whereTeam(Selection& sel, const team_tag& t)
+    {
+        const unsigned long long* team = getInstance()->m_team.data();
+        size_t n = std::min(sel.size(), count());
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= (team[i] == t.key.head);
+        }
+    }
+
+
+    void StatTable::whereAtLeast(Selection& sel, Stat::Id id, unsigned int min)
+    {
+        const quint32* col = column(id);
+        size_t n = std::min(sel.size(), count());
+
+        for (size_t i = 0; i < n; i++) {
+            sel[i] &= (col[i] >= min);
+        }
+    }
+
+
+    unsigned long long StatTable::sum(const Selection& sel, Stat::Id id)
+    {
+        return sumSelected(column(id), sel.data(), std::min(sel.size(), count()));
+    }
+
+
+    unsigned int StatTable::min(const Selection& sel, Stat::Id id)
+    {
+        quint32 lo, hi;
+
+        extremesSelected(column(id), sel.data(), std::min(sel.size(), count()), lo, hi);
+
+        return lo;
+    }
+
+
+    unsigned int StatTable::max(const Selection& sel, Stat::Id id)
+    {
+        quint32 lo, hi;
+
+        extremesSelected(column(id), sel.data(), std::min(sel.size(), count()), lo, hi);
+
+        return hi;
+    }
+
+
+    StatTable::YearTotals StatTable::sumByYear(const Selection& sel, Stat::Id id)
+    {
+        const StatTable* st = getInstance();
+        const quint32* col = column(id);
+        size_t n = std::min(sel.size(), count());
+        YearTotals totals;
+
+        for (size_t i = 0; i < st->m_years.size(); i++) {
+            size_t first = std::min(st->m_yearStart[i], n);
+            size_t last = std::min(st->m_yearStart[i + 1], n);
+
+            totals.push_back(std::make_pair(st->m_years[i],
+                                            sumSelected(col + first, sel.data() + first, last - first)));
+        }
+
+        return totals;
+    }
+
+
+    void StatTable::obp(std::vector<Stat::Metric>& rates)
+    {
+        const quint32* h1b = column(Stat::BattingH1B);
+        const quint32* h2b = column(Stat::BattingH2B);
+        const quint32* gdr = column(Stat::BattingGDR);
+        const quint32* h3b = column(Stat::BattingH3B);
+        const quint32* hr  = column(Stat::BattingHR);
+        const quint32* bb  = column(Stat::BattingBB);
+        const quint32* ibb = column(Stat::BattingIBB);
+        const quint32* hbp = column(Stat::BattingHBP);
+        const quint32* ab  = column(Stat::BattingAB);
+        const quint32* sf  = column(Stat::BattingSF);
+        size_t n = count();
+
+        rates.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            quint32 onBase = h1b[i] + h2b[i] + gdr[i] + h3b[i] + hr[i] + bb[i] + ibb[i] + hbp[i];
+            quint32 d = ab[i] + bb[i] + ibb[i] + hbp[i] + sf[i];
+
+            rates[i] = rate(onBase, d);
+        }
+    }
+
+
+    void StatTable::slg(std::vector<Stat::Metric>& rates)
+    {
+        const quint32* h1b = column(Stat::BattingH1B);
+        const quint32* h2b = column(Stat::BattingH2B);
+        const quint32* gdr = column(Stat::BattingGDR);
+        const quint32* h3b = column(Stat::BattingH3B);
+        const quint32* hr  = column(Stat::BattingHR);
+        const quint32* ab  = column(Stat::BattingAB);
+        size_t n = count();
+
+        rates.resize(n);
+
+        for (size_t i = 0; i < n; i++) {
+            quint32 bases = h1b[i] + (2 * (h2b[i] + gdr[i])) + (3 * h3b[i]) + (4 * hr[i]);
+
+            rates[i] = rate(bases, ab[i]);
+        }
+    }
+
+
+    Stat::Metric StatTable::obp(const Selection& sel)
+    {
+        unsigned long long onBase = sum(sel, Stat::BattingH1B) + sum(sel, Stat::BattingH2B) +
+                                    sum(sel, Stat::BattingGDR) + sum(sel, Stat::BattingH3B) +
+                                    sum(sel, Stat::BattingHR) + sum(sel, Stat::BattingBB) +
+                                    sum(sel, Stat::BattingIBB) + sum(sel, Stat::BattingHBP);
+        unsigned long long d = sum(sel, Stat::BattingAB) + sum(sel, Stat::BattingBB) +
+                               sum(sel, Stat::BattingIBB) + sum(sel, Stat::BattingHBP) +
+                               sum(sel, Stat::BattingSF);
+
+        return rate(onBase, d);
+    }
+
+
+    Stat::Metric StatTable::slg(const Selection& sel)
+    {
+        unsigned long long bases = sum(sel, Stat::BattingH1B) +
+                                   (2 * (sum(sel, Stat::BattingH2B) + sum(sel, Stat::BattingGDR))) +
+                                   (3 * sum(sel, Stat::BattingH3B)) +
+                                   (4 * sum(sel, Stat::BattingHR));
+
+        return rate(bases, sum(sel, Stat::BattingAB));
+    }
+}
@@ -0,0 +1,102 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include "bb_defs.h"
+#include "bb_stat.h"
+
+#include <utility>
+#include <vector>
+
+namespace Baseball {
+
+    // The StatTable holds the counting statistics of every player season as
+    // columns, one uint32 column per Stat::Id with one entry per season, so
+    // league totals and rates for everyone are a pass over a few arrays
+    // rather than a walk of every player's years.  Seasons are ordered by
+    // year, so the seasons of one year are a contiguous range of rows.  Like
+    // the PlayTable it is a copy, and has to be rebuilt after the player
+    // statistics change.
+    //
+    // Seasons are filtered through a Selection, which has one flag per
+    // season, and the where functions combine as "and".
+    class StatTable : public Singleton<StatTable>
+    {
+    public:
+
+        typedef std::vector<unsigned char> Selection;
+
+        // a total for every year in the table, in year order
+        typedef std::vector<std::pair<int, unsigned long long> > YearTotals;
+
+        // rebuilds the table from the years of every player
+        static void build();
+
+        static size_t count() { return getInstance()->m_year.size(); }
+
+        // returns a selection of every season
+        static Selection all();
+
+        // the values of id for every season, count() of them
+        static const quint32* column(Stat::Id id);
+
+        static void whereYear(Selection& sel, int first, int last);
+        static void wherePlayer(Selection& sel, const player_tag& t);
+        static void whereTeam(Selection& sel, const team_tag& t);
+
+        // seasons with a value of id of at least min, such as qualifying
+        // plate appearances
+        static void whereAtLeast(Selection& sel, Stat::Id id, unsigned int min);
+
+        // totals and extremes of id over the selected seasons.  With no
+        // season selected min is 0xffffffff and max is 0.
+        static unsigned long long sum(const Selection& sel, Stat::Id id);
+        static unsigned int min(const Selection& sel, Stat::Id id);
+        static unsigned int max(const Selection& sel, Stat::Id id);
+
+        static YearTotals sumByYear(const Selection& sel, Stat::Id id);
+
+        // on base percentage and slugging of every season, as computed by
+        // Stat::Batting, zero for a season without a denominator
+        static void obp(std::vector<Stat::Metric>& rates);
+        static void slg(std::vector<Stat::Metric>& rates);
+
+        // on base percentage and slugging of the selected seasons together
+        static Stat::Metric obp(const Selection& sel);
+        static Stat::Metric slg(const Selection& sel);
+
+    protected:
+
+        std::vector<quint32> m_columns[Stat::NUM_IDS];
+
+        // year of each season, and the packed tags of the player and team,
+        // see tag_key.  Player and team ids fit in the head of the key.
+        std::vector<int> m_year;
+        std::vector<unsigned long long> m_player;
+        std::vector<unsigned long long> m_team;
+
+        // the seasons of m_years[i] are the rows m_yearStart[i] up to
+        // m_yearStart[i + 1]
+        std::vector<int> m_years;
+        std::vector<size_t> m_yearStart;
+
+        void clear();
+    };
+}
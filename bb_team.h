@@ -26,9 +26,14 @@
 #include <QDate>
 
 namespace Baseball {
+
+    class Snapshot;
+
     namespace Team {
         class Record : public CoreRecord
         {
+            friend class Baseball::Snapshot;
+
         public:
             Record(const tag& p) : CoreRecord(p) {}
 
@@ -18,59 +18,290 @@
  *
  */
 #include "parse.h"
+#include "parse_context.h"
+#include "parse_reader.h"
+#include "parse_event.h"
+#include "parse_worker.h"
+#include "parse_pipeline.h"
 #include "baseball.h"
+#include "bb_snapshot.h"
 
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
+#include <QCryptographicHash>
 #include <QThread>
+#include <QThreadPool>
 
 
-static QStringList splitString(const QString& sz)
-{
-    QStringList l;
-    int start = 0;
-    bool insz = false;
+namespace {
 
-    for (int i = 0; i < sz.length(); i++) {
-        char c = sz.at(i).toLatin1();
+    // Counts the states parsing a file will create.  Each play line links
+    // one state to the next, and the first play of every half inning starts
+    // a state of its own.
+    struct StateCount
+    {
+        StateCount() : count(0), inning(0), visiting(0) {}
 
-        if (c == '"') {
-            insz = !insz;
-        } else if ((c == ',') && (!insz)) {
-            int len = (i - start);
-            if (len > 0) {
-                l.push_back(sz.mid(start, len));
-            } else {
-                l.push_back(QString());
+        void add(const FieldList& line)
+        {
+            if (line.at(0) == "id") {
+                inning = 0;
+            } else if (line.at(0) == "play") {
+                unsigned int i = line.at(1).toUInt();
+                char v = line.at(2).at(0);
+
+                if ((inning == 0) || (i != inning) || (v != visiting)) {
+                    count++;
+                }
+
+                inning = i;
+                visiting = v;
+                count++;
             }
-            start = i + 1;
         }
-    }
 
-    if (start < sz.length()) {
-        l.push_back(sz.right(sz.length() - start));
-    }
+        unsigned int count;
+
+        unsigned int inning;
+        char visiting;
+    };
 
-    if (insz) {
-        // we have unclosed double quotes
-    }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
+const char* Parser::SNAPSHOT_FILE = "sabre.snapshot";
+
+Parser::Parser(const QString& dbPath, Sabre::Output* out) :
+    m_output(out),
+    m_dbPath(dbPath),
+    m_workers(1),
+    m_pipeline(NULL),
+    m_verifyEvents(false),
+    m_eventMismatches(0),
+    m_lazyGames(false)
+{
+    initEvents();
+}
+
+Parser::~Parser()
+{
+    delete m_pipeline;
+}
+
 void Parser::parse()
 {
+    Baseball::Manifest::clear();
+    Baseball::Manifest::setYears(m_years);
+
     parseBallparks();
 
     parseRetroIds();
 
     parseYearlyData();
 
+    reportPipeline();
+
+    if (m_verifyEvents) {
+        m_output->log("Event check: %u mismatched events", m_eventMismatches);
+    }
+
+    if (!Baseball::Snapshot::save(snapshotPath())) {
+        m_output->log("Unable to write snapshot %s", snapshotPath().toStdString().c_str());
+    }
+
+    emit finished();
+}
+
+void Parser::load()
+{
+    m_output->log("Loading snapshot %s...", snapshotPath().toStdString().c_str());
+
+    if (!Baseball::Snapshot::load(snapshotPath())) {
+        m_output->log("Unable to read snapshot %s", snapshotPath().toStdString().c_str());
+    }
+
     emit finished();
 }
 
+void Parser::refresh()
+{
+    // without a manifest there is nothing to compare the files against
+    if (Baseball::Manifest::count() == 0) {
+        m_output->log("No manifest for %s, parsing every file", m_dbPath.absolutePath().toStdString().c_str());
+
+        parse();
+        return;
+    }
+
+    unsigned int changed = 0, removed = 0;
+
+    // only the years the tables were built from are refreshed, a year not
+    // parsed before is not one which was added since
+    if (m_years.isEmpty()) {
+        m_years = Baseball::Manifest::years();
+    }
+
+    m_output->log("Refreshing %s...", m_dbPath.absolutePath().toStdString().c_str());
+
+    // take back whatever was produced by files which no longer exist
+    std::vector<QString> gone;
+    const Baseball::Manifest::Entries& entries = Baseball::Manifest::entries();
+
+    for (Baseball::Manifest::Entries::const_iterator it = entries.begin();
+         it != entries.end(); it++) {
+        if (!QFile::exists(m_dbPath.absoluteFilePath(it->first))) {
+            gone.push_back(it->first);
+        }
+    }
+
+    for (unsigned int i = 0; i < gone.size(); i++) {
+        Baseball::Manifest::retract(gone[i]);
+        removed++;
+    }
+
+    QFileInfoList fil = m_dbPath.entryInfoList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+
+    for (int i = 0; i < fil.size(); i++) {
+        QDir d(fil.at(i).absoluteFilePath());
+        QDate y = QDate::fromString(d.dirName(), "yyyy");
+
+        if ((!y.isValid()) || (!yearRestricted(y.year()))) continue;
+
+        // teams and rosters only set fields of their records, so a changed
+        // file is simply read again over the old values
+        QString team = d.absoluteFilePath(QString("TEAM%1").arg(d.dirName()));
+
+        if ((QFile::exists(team)) && (fileChanged(team))) {
+            parseTeams(d);
+            changed++;
+        }
+
+        QStringList filters;
+        filters << "*.ROS" << "*.ros";
+
+        QStringList files = d.entryList(filters, QDir::Files | QDir::NoSymLinks | QDir::CaseSensitive);
+
+        for (int j = 0; j < files.size(); j++) {
+            QString f(d.absoluteFilePath(files.at(j)));
+
+            if (fileChanged(f)) {
+                parseRoster(f, y.year());
+                changed++;
+            }
+        }
+
+        // event files are parsed again only after the games and statistics
+        // of their old contents have been taken out
+        filters.clear();
+        filters << "*.EVA" << "*.EVN";
+
+        files = d.entryList(filters, QDir::Files | QDir::NoSymLinks);
+
+        QStringList games;
+
+        for (int j = 0; j < files.size(); j++) {
+            QString f(d.absoluteFilePath(files.at(j)));
+
+            if (fileChanged(f)) {
+                Baseball::Manifest::retract(relativePath(f));
+                games << f;
+            }
+        }
+
+        if (!games.isEmpty()) {
+            m_output->raw("Processing games for year %s", y.toString("yyyy").toStdString().c_str());
+
+            parseGameFiles(games, y.year());
+            changed += games.size();
+
+            m_output->flush();
+        }
+    }
+
+    reportPipeline();
+
+    m_output->log("Refreshed %u changed file(s), removed %u file(s)", changed, removed);
+
+    if ((changed > 0) || (removed > 0)) {
+        if (!Baseball::Snapshot::save(snapshotPath())) {
+            m_output->log("Unable to write snapshot %s", snapshotPath().toStdString().c_str());
+        }
+    }
+
+    emit finished();
+}
+
+QString Parser::snapshotPath() const
+{
+    return m_dbPath.absoluteFilePath(SNAPSHOT_FILE);
+}
+
+
+QString Parser::relativePath(const QString& fileName) const
+{
+    return m_dbPath.relativeFilePath(fileName);
+}
+
+
+QByteArray Parser::fileHash(const QString& fileName)
+{
+    QFile f(fileName);
+    QCryptographicHash h(QCryptographicHash::Sha1);
+
+    if (f.open(QIODevice::ReadOnly)) {
+        h.addData(&f);
+    }
+
+    return h.result();
+}
+
+
+Baseball::Manifest::Entry* Parser::stampFile(const QString& fileName)
+{
+    return stampFile(fileName, fileHash(fileName));
+}
+
+
+Baseball::Manifest::Entry* Parser::stampFile(const QString& fileName, const QByteArray& hash)
+{
+    QFileInfo fi(fileName);
+    Baseball::Manifest::Entry* e = Baseball::Manifest::add(relativePath(fileName));
+
+    e->size = fi.size();
+    e->modified = fi.lastModified();
+    e->hash = hash;
+
+    return e;
+}
+
+
+bool Parser::fileChanged(const QString& fileName)
+{
+    Baseball::Manifest::Entry* e = Baseball::Manifest::find(relativePath(fileName));
+
+    if (!e) return true;
+
+    QFileInfo fi(fileName);
+
+    if ((fi.size() == e->size) && (fi.lastModified() == e->modified)) {
+        return false;
+    }
+
+    // the file was touched, but it only changed if its contents did
+    if (fileHash(fileName) != e->hash) {
+        return true;
+    }
+
+    e->size = fi.size();
+    e->modified = fi.lastModified();
+
+    return false;
+}
+
 bool Parser::parseBallparks()
 {
     bool ret = true;
@@ -79,14 +310,14 @@ bool Parser::parseBallparks()
     filters << "parks.dat";
 
     QStringList files = m_dbPath.entryList(filters, QDir::Files | QDir::NoSymLinks);
-    QFile f(m_dbPath.absolutePath() + QDir::separator() + files.at(0));
+    FileReader f(m_dbPath.absolutePath() + QDir::separator() + files.at(0));
+    FieldList chunks;
 
     m_output->log("Processing file %s...", f.fileName().toStdString().c_str());
 
-    if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (f.open()) {
         while (!f.atEnd()) {
-            QString line = f.readLine();
-            QStringList chunks = line.split(",");
+            chunks.split(f.readLine());
 
             if (chunks.size() >= 9) {
                 Baseball::ballpark_tag b(chunks.at(0).toStdString());
@@ -98,12 +329,12 @@ bool Parser::parseBallparks()
                 r->city = chunks.at(3).toStdString();
                 r->state = chunks.at(4).toStdString();
 
-                r->opened = QDate::fromString(chunks.at(5), "MM/dd/yyyy");
-                r->closed = QDate::fromString(chunks.at(6), "MM/dd/yyyy");
+                r->opened = QDate::fromString(chunks.at(5).toString(), "MM/dd/yyyy");
+                r->closed = QDate::fromString(chunks.at(6).toString(), "MM/dd/yyyy");
 
                 r->league = Baseball::Parse<Baseball::League>(chunks.at(7).toStdString());
 
-                r->notes = line.section(',', 8).toStdString();
+                r->notes = chunks.rest(8).toStdString();
             }
         }
     } else {
@@ -124,14 +355,14 @@ bool Parser::parseRetroIds()
     filters << "retroid.dat";
 
     QStringList files = m_dbPath.entryList(filters, QDir::Files | QDir::NoSymLinks);
-    QFile f(m_dbPath.absolutePath() + QDir::separator() + files.at(0));
+    FileReader f(m_dbPath.absolutePath() + QDir::separator() + files.at(0));
+    FieldList chunks;
 
     m_output->log("Processing file %s...", f.fileName().toStdString().c_str());
 
-    if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (f.open()) {
         while (!f.atEnd()) {
-            QString line = f.readLine();
-            QStringList chunks = line.split(",");
+            chunks.split(f.readLine());
 
             if (chunks.size() == 4) {
                 // surname, first name, retroid, debut
@@ -144,7 +375,7 @@ bool Parser::parseRetroIds()
                 // create a player tag from the retrosheet id
                 Baseball::player_tag p(chunks.at(2).toStdString());
 
-                char x = chunks.at(2).toStdString().at(5);
+                char x = chunks.at(2).at(5);
 
                 // TODO: managers/coaches/umpires
                 if ((x == '8') || (x == '9')) continue;
@@ -155,7 +386,7 @@ bool Parser::parseRetroIds()
                 r->surName = chunks.at(0).toStdString();
                 r->firstName = chunks.at(1).toStdString();
 
-                r->debut = QDate::fromString(chunks.at(3), "MM/dd/yyyy");
+                r->debut = QDate::fromString(chunks.at(3).toString(), "MM/dd/yyyy");
             }
         }
     } else {
@@ -223,12 +454,13 @@ bool Parser::parseTeams(const QDir& path)
     bool ret = true;
 
     QString file = QString("TEAM%1").arg(path.dirName());
-    QFile f(path.absolutePath() + QDir::separator() + file);
+    FileReader f(path.absolutePath() + QDir::separator() + file);
+    FieldList chunks;
     QDate y = QDate::fromString(path.dirName(), "yyyy");
 
 //    m_output->log("Processing file %s...", f.fileName().toStdString().c_str());
 
-    if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    if (f.open()) {
         // retrosheet 8 character id,last name, first name,bats,throws,3 letter team id,position
 
         int yr = y.year();
@@ -236,18 +468,14 @@ bool Parser::parseTeams(const QDir& path)
         m_output->raw("Parsing Teams:");
 
         while (!f.atEnd()) {
-            QString line = f.readLine();
-            QStringList chunks = line.split(",");
+            chunks.split(f.readLine());
 
             if (chunks.size() == 4) {
-                QString tsz = chunks.at(0);
-                tsz.remove(QRegExp("[\\r\\n]"));
-
-                Baseball::team_tag t(tsz.toStdString());
+                Baseball::team_tag t(chunks.at(0).toStdString());
 
                 Baseball::Team::Record *r = Baseball::Team::Table::createRecord(t);
 
-                char l = chunks.at(1).toStdString().at(0);
+                char l = chunks.at(1).at(0);
 
                 r->year(yr).validate();
                 r->year(yr).league = ((l == 'A') ? Baseball::AL : Baseball::NL);
@@ -259,6 +487,8 @@ bool Parser::parseTeams(const QDir& path)
         }
 
         m_output->flush();
+
+        stampFile(f.fileName());
     }
 
     return ret;
@@ -278,50 +508,56 @@ bool Parser::parseRosters(const QDir& path)
     m_output->raw("Processing rosters");
 
     for (int i = 0; i < files.size(); i++) {
-        QFile f(path.absolutePath() + QDir::separator() + files.at(i));
-
         m_output->raw(".");
 
-        if (f.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            // retrosheet 8 character id,last name, first name,bats,throws,3 letter team id,position
+        ret &= parseRoster(path.absolutePath() + QDir::separator() + files.at(i), y.year());
+    }
+
+    m_output->flush();
+
+    return ret;
+}
+
 
-            while (!f.atEnd()) {
-                QString line = f.readLine();
-                QStringList chunks = line.split(",");
+bool Parser::parseRoster(const QString& fileName, int year)
+{
+    FileReader f(fileName);
+    FieldList chunks;
 
-                if (chunks.size() == 7) {
-                    // create a player tag from the retrosheet id
-                    Baseball::player_tag p(chunks.at(0).toStdString());
+    if (f.open()) {
+        // retrosheet 8 character id,last name, first name,bats,throws,3 letter team id,position
 
-                    // create a player record
-                    Baseball::Player::Record* r = Baseball::Player::Table::get(p);
+        while (!f.atEnd()) {
+            chunks.split(f.readLine());
 
-                    // roster setup should create each team/year and set the handedness for that team/year
-                    QString tsz = chunks.at(5);
-                    tsz.remove(QRegExp("[\\r\\n]"));
+            if (chunks.size() == 7) {
+                // create a player tag from the retrosheet id
+                Baseball::player_tag p(chunks.at(0).toStdString());
 
-                    Baseball::Player::Record::TeamYear t(y.year(), Baseball::team_tag(tsz.toStdString()));
+                // create a player record
+                Baseball::Player::Record* r = Baseball::Player::Table::get(p);
 
-                    r->year(t).validate();
+                // roster setup should create each team/year and set the handedness for that team/year
+                Baseball::Player::Record::TeamYear t(year, Baseball::team_tag(chunks.at(5).toStdString()));
 
-                    r->year(t).bats = Baseball::Parse<Baseball::Player::Handedness>(chunks.at(3).toStdString());
-                    r->year(t).throws = Baseball::Parse<Baseball::Player::Handedness>(chunks.at(4).toStdString());
+                r->year(t).validate();
 
-                    //mccua001
-                }
+                r->year(t).bats = Baseball::Parse<Baseball::Player::Handedness>(chunks.at(3).toStdString());
+                r->year(t).throws = Baseball::Parse<Baseball::Player::Handedness>(chunks.at(4).toStdString());
+
+                //mccua001
             }
+        }
 
-        } else {
-            // TODO: error: could not open %1
-            qWarning("Error: could not open %s", f.fileName().toStdString().c_str());
+        stampFile(fileName);
+    } else {
+        // TODO: error: could not open %1
+        qWarning("Error: could not open %s", f.fileName().toStdString().c_str());
 
-            ret = false;
-        }
+        return false;
     }
 
-    m_output->flush();
-
-    return ret;
+    return true;
 }
 
 
@@ -333,139 +569,298 @@ bool Parser::parseGameData(const QDir& d, const QDate& y)
     filters << "*.EVA" << "*.EVN";
 
     QStringList files = d.entryList(filters, QDir::Files | QDir::NoSymLinks);
+    QStringList paths;
+
+    for (int i = 0; i < files.size(); i++) {
+        paths << (d.absolutePath() + QDir::separator() + files.at(i));
+    }
 
     m_output->raw("Processing games");
 
-    for (int i = 0; i < files.size(); i++) {
-        QString f(d.absolutePath() + QDir::separator() + files.at(i));
+    ret |= parseGameFiles(paths, y.year());
 
-        m_output->raw(".");
+    m_output->flush();
 
-        ret |= parseFile(f, y.year());
+    return ret;
+}
+
+
+bool Parser::parseGameFiles(const QStringList& files, int year)
+{
+    bool ret = true;
+
+    if (m_lazyGames) {
+        for (int i = 0; i < files.size(); i++) {
+            m_output->raw(".");
+
+            ret &= indexGameFile(files.at(i), year);
+        }
+
+        reduceStats();
+
+        return ret;
     }
 
-    m_output->flush();
+    if (m_workers > 1) {
+        if (!m_pipeline) {
+            m_pipeline = new ParsePipeline(this, m_workers);
+        }
+
+        ret = m_pipeline->run(files, year);
+    } else {
+        // each file still goes through a batch, so that what it produced
+        // can be recorded in the manifest
+        for (int i = 0; i < files.size(); i++) {
+            ParseBatch batch;
+
+            m_output->raw(".");
+
+            ParseContext ctx(files.at(i), &batch);
+            QByteArray hash;
+
+            // a file which could not be read is left out of the manifest,
+            // so that a refresh tries it again
+            if (!parseFile(ctx, year, &hash)) {
+                ret = false;
+                continue;
+            }
+
+            m_eventMismatches += ctx.mismatches;
+
+            commitBatch(files.at(i), batch, hash);
+        }
+    }
+
+    reduceStats();
 
     return ret;
 }
 
+
+bool Parser::indexGameFile(const QString& fileName, int year)
+{
+    FileReader file(fileName);
+    FieldList chunks;
+    ParseBatch batch;
+    ParseContext ctx(fileName, &batch);
+    Baseball::Game::Record* g = NULL;
+
+    if (!file.open()) {
+        qWarning("Error: could not open %s", fileName.toStdString().c_str());
+        return false;
+    }
+
+    QString source = relativePath(fileName);
+
+    // every line is parsed so that the statistics of the games are logged,
+    // but of the plays only the byte range of each game is kept.  A game
+    // runs from its id line up to the next one.
+    while (!file.atEnd()) {
+        qint64 pos = file.pos();
+
+        chunks.split(file.readLine());
+
+        parseRecord(ctx, chunks, year);
+
+        if ((chunks.at(0) == "id") && (ctx.game)) {
+            if (g) {
+                g->source.length = pos - g->source.offset;
+            }
+
+            g = ctx.game;
+
+            g->source.fileName = source;
+            g->source.offset = pos;
+        }
+
+        ctx.lineNumber++;
+    }
+
+    if (g) {
+        g->source.length = file.pos() - g->source.offset;
+    }
+
+    m_eventMismatches += ctx.mismatches;
+
+    // the games are committed as stubs, the GameLoader parses their plays
+    // again when they are used
+    batch.dropStates();
+    batch.commit(m_unreduced, stampFile(fileName, file.hash()));
+
+    return true;
+}
+
+
+void Parser::reportPipeline()
+{
+    if (m_pipeline) {
+        m_pipeline->report(m_output);
+
+        delete m_pipeline;
+        m_pipeline = NULL;
+    }
+}
+
+
+void Parser::commitBatch(const QString& fileName, ParseBatch& batch, const QByteArray& hash)
+{
+    batch.commit(m_unreduced, stampFile(fileName, hash));
+}
+
+
+void Parser::reduceStats()
+{
+    std::vector<const Baseball::StatLog*> logs;
+
+    logs.reserve(m_unreduced.size());
+
+    for (unsigned int i = 0; i < m_unreduced.size(); i++) {
+        logs.push_back(&m_unreduced[i]->stats);
+    }
+
+    Baseball::StatLog::reduce(logs);
+
+    m_unreduced.clear();
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
-bool Parser::parseFile(const QString& fileName, int year)
+bool Parser::parseFile(ParseContext& ctx, int year, QByteArray* hash)
 {
-    bool ret = false;
-    QFile file(fileName);
-    m_lineNumber = 1;
+    FileReader file(ctx.fileName);
+    FieldList chunks;
+
+    if (!file.open()) {
+        qWarning("Error: could not open %s", ctx.fileName.toStdString().c_str());
+        return false;
+    }
+
+    if (ctx.batch) {
+        StateCount states;
+        qint64 pos = 0;
 
-    m_fileName = fileName;
+        while (pos < file.size()) {
+            chunks.split(FileReader::nextLine(file.data(), file.size(), pos));
+            states.add(chunks);
+        }
 
-    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-//        m_output->log("Processing file %s...", file.fileName().toStdString().c_str());
-        size_t g = Baseball::Game::Table::count();
+        ctx.batch->reserveStates(states.count);
+    }
 
-        while (!file.atEnd()) {
-            QString line = file.readLine();
-            line.remove(QRegExp("[\\r\\n]"));
+    // lines and fields refer directly into the mapped file, only the event
+    // portion of a play is copied out for the event parser
+//    m_output->log("Processing file %s...", file.fileName().toStdString().c_str());
+    while (!file.atEnd()) {
+        chunks.split(file.readLine());
 
-            QStringList chunks = line.split(",");
+        parseRecord(ctx, chunks, year);
 
-            if (chunks.at(0).compare("id") == 0) {
-                Baseball::game_tag g(chunks.at(1).toStdString());
+        ctx.lineNumber++;
+    }
 
-                m_curGame = Baseball::Game::Table::createRecord(g);
-                m_curGame->year = year;
+    if (hash) {
+        *hash = file.hash();
+    }
+
+    return true;
+}
 
-                m_curInstance = Baseball::Game::Instance::STARTER;
-            } else if (chunks.at(0).compare("info") == 0) {
-                if (parseInfo(chunks) == false) {
-//                    qWarning("Parse error in file %s line %d",
-//                             file.fileName().toStdString().c_str(),
-//                             m_lineNumber);
-                }
-            } else if (chunks.at(0).compare("data") == 0) {
-            } else if (chunks.at(0).compare("com") == 0) {
-            } else if (chunks.at(0).compare("badj") == 0) {
-            } else if ((chunks.at(0).compare("start") == 0) ||
-                       (chunks.at(0).compare("sub") == 0)) {
-                parseSub(line);
-            } else if (chunks.at(0).compare("play") == 0) {
-                if (parsePlay(line) == false) {
-                    qWarning("Parse error in file %s line %d",
-                             file.fileName().toStdString().c_str(),
-                             m_lineNumber);
-                }
-            }
 
-            m_lineNumber++;
+void Parser::parseRecords(ParseContext& ctx, int year, const std::vector<FieldList>& records)
+{
+    if (ctx.batch) {
+        StateCount states;
+
+        for (unsigned int i = 0; i < records.size(); i++) {
+            states.add(records[i]);
         }
+
+        ctx.batch->reserveStates(states.count);
     }
 
-    return ret;
+    for (unsigned int i = 0; i < records.size(); i++) {
+        parseRecord(ctx, records[i], year);
+
+        ctx.lineNumber++;
+    }
 }
 
 
-bool Parser::parseSub(const QString& line)
+void Parser::parseRecord(ParseContext& ctx, const FieldList& chunks, int year)
+{
+    if (chunks.at(0) == "id") {
+        Baseball::game_tag g(chunks.at(1).toStdString());
+
+        ctx.beginGame(ctx.createGame(g));
+        ctx.game->year = year;
+    } else if (chunks.at(0) == "info") {
+        if (parseInfo(ctx, chunks) == false) {
+//            qWarning("Parse error in file %s line %d",
+//                     ctx.fileName.toStdString().c_str(),
+//                     ctx.lineNumber);
+        }
+    } else if (chunks.at(0) == "data") {
+    } else if (chunks.at(0) == "com") {
+    } else if (chunks.at(0) == "badj") {
+    } else if ((chunks.at(0) == "start") ||
+               (chunks.at(0) == "sub")) {
+        parseSub(ctx, chunks);
+    } else if (chunks.at(0) == "play") {
+        if (parsePlay(ctx, chunks) == false) {
+            qWarning("Parse error in file %s line %d",
+                     ctx.fileName.toStdString().c_str(),
+                     ctx.lineNumber);
+        }
+    }
+}
+
+
+bool Parser::parseSub(ParseContext& ctx, const FieldList& parts)
 {
     // add starting roster info to game
     // make sure we create team/years for all players
     // if they don't already have them
-    QStringList parts = line.split(",");
     bool ok;
     bool np = false;
 
-    if (!m_curGame) return false;
+    if (!ctx.game) return false;
 
-    // remove start/sub
-    parts.pop_front();
+    // field 0 is start/sub
 
     // parse tag
-    Baseball::player_tag t(parts.at(0).toStdString());
-    parts.pop_front();
+    Baseball::player_tag t(parts.at(1).toStdString());
 
-    // parse name
-    parts.pop_front();
+    // field 2 is the name
 
     // parse home/visiting team
-    int v = parts.at(0).toInt(&ok);
+    int v = parts.at(3).toInt(&ok);
     if (!ok) return false;
-    parts.pop_front();
 
     // parse order
-    uint o = parts.at(0).toUInt(&ok);
+    uint o = parts.at(4).toUInt(&ok);
     if (!ok) return false;
-    parts.pop_front();
 
     // parse position
-    Baseball::Position p = Baseball::Parse<Baseball::Position>(parts.at(0).toStdString());
+    Baseball::Position p = Baseball::Parse<Baseball::Position>(parts.at(5).toStdString());
 
     // add to the lineup
-    np = m_curGame->lineup.sub(t, m_curInstance, p, o, (v == 0));
+    np = ctx.game->lineup.sub(t, ctx.instance, p, o, (v == 0));
 
     // hopefully, at this point all is well, however we want to check for
     // team/years for this player.  If this player does not have a team year
     // for this game, then one should be created here.
-    Baseball::Player::Record* r = Baseball::Player::Table::get(t);
+    Baseball::Player::Record* r = ctx.player(t);
 
     if (r) {
-        Baseball::team_tag tt;
-
-        if (v == 0) {
-            tt = m_curGame->teamVisiting;
-        } else {
-            tt = m_curGame->teamHome;
-        }
-
-        Baseball::Player::Record::TeamYear t(m_curGame->year, tt);
-
-        r->year(t).validate();
+        ctx.appear(r, (v == 0));
 
         if (np) {
-            r->year(t).general.GP++;
+            ctx.credit(r, (v == 0), Baseball::Stat::GeneralGP);
 
-            if (m_curInstance == Baseball::Game::Instance::STARTER) {
-                r->year(t).general.GS++;
+            if (ctx.instance == Baseball::Game::Instance::STARTER) {
+                ctx.credit(r, (v == 0), Baseball::Stat::GeneralGS);
             }
         }
     }
@@ -474,21 +869,21 @@ bool Parser::parseSub(const QString& line)
 }
 
 
-bool Parser::parseInfo(const QStringList& info)
+bool Parser::parseInfo(ParseContext& ctx, const FieldList& info)
 {
     bool ret = true;
 
-    if (!m_curGame) return false;
+    if (!ctx.game) return false;
 
     if (info.size() >= 3) {
-        QString var = info.at(1);
-
-        if (var.compare("visteam") == 0) {
-            m_curGame->teamVisiting = Baseball::team_tag(info.at(2).toStdString());
-        } else if (var.compare("hometeam") == 0) {
-            m_curGame->teamHome = Baseball::team_tag(info.at(2).toStdString());
-        } else if (var.compare("date") == 0) {
-        } else if (var.compare("number") == 0) {
+        FieldRef var = info.at(1);
+
+        if (var == "visteam") {
+            ctx.game->teamVisiting = Baseball::team_tag(info.at(2).toStdString());
+        } else if (var == "hometeam") {
+            ctx.game->teamHome = Baseball::team_tag(info.at(2).toStdString());
+        } else if (var == "date") {
+        } else if (var == "number") {
             bool ok;
             int num = info.at(2).toInt(&ok);
 
@@ -496,28 +891,28 @@ bool Parser::parseInfo(const QStringList& info)
                 switch (num) {
                 default:
                 case 0:
-                    m_curGame->type = Baseball::Game::Record::SingleGame;
+                    ctx.game->type = Baseball::Game::Record::SingleGame;
                     break;
                 case 1:
-                    m_curGame->type = Baseball::Game::Record::DoubleHeaderFirst;
+                    ctx.game->type = Baseball::Game::Record::DoubleHeaderFirst;
                     break;
                 case 2:
-                    m_curGame->type = Baseball::Game::Record::DoubleHeaderSecond;
+                    ctx.game->type = Baseball::Game::Record::DoubleHeaderSecond;
                     break;
                 }
             } else {
-                m_curGame->type = Baseball::Game::Record::Unknown;
+                ctx.game->type = Baseball::Game::Record::Unknown;
             }
-        } else if (var.compare("starttime") == 0) {
+        } else if (var == "starttime") {
             // TODO
-        } else if (var.compare("daynight") == 0) {
-            if (info.at(2).compare("night") == 0) {
-                m_curGame->night = true;
+        } else if (var == "daynight") {
+            if (info.at(2) == "night") {
+                ctx.game->night = true;
             } else {
-                m_curGame->night = false;
+                ctx.game->night = false;
             }
-        } else if (var.compare("usedh") == 0) {
-            m_curGame->useDH = Baseball::Parse<bool>(info.at(2).toStdString());
+        } else if (var == "usedh") {
+            ctx.game->useDH = Baseball::Parse<bool>(info.at(2).toStdString());
         } else {
             ret = false;
         }
@@ -527,97 +922,91 @@ bool Parser::parseInfo(const QStringList& info)
 }
 
 
-bool Parser::parsePlay(const QString& line)
+bool Parser::parsePlay(ParseContext& ctx, const FieldList& parts)
 {
     bool ret = true;
-    QStringList parts = line.split(",");
 
-    if (!m_curGame) return false;
+    if (!ctx.game) return false;
 
-    // pop the front, which is "play"
-    parts.pop_front();
+    // field 0 is "play"
 
     // get/create the link to the new state
     // if the last state is invalid, or an endgame state, then create a
     // brand new state variable and set the game state
-    if ((Baseball::isValid(m_lastState) == false) ||
-        (m_lastState->type == Baseball::State::SNULL) ||
-        (m_lastState->type == Baseball::State::SENDGAME)) {
+    if ((Baseball::isValid(ctx.lastState) == false) ||
+        (ctx.lastState->type == Baseball::State::SNULL) ||
+        (ctx.lastState->type == Baseball::State::SENDGAME)) {
 
-        m_currentState = Baseball::StateManager::createState(Baseball::State::S___0);
-        m_curGame->plays = m_currentState;
+        ctx.currentState = ctx.createState(Baseball::State::S___0);
+        ctx.game->plays = ctx.currentState;
 
     // if the current state is an inning end, we will allocate a new state
     // and attach it to the chain
-    } else if (m_lastState->endInning()) {
-        m_currentState = Baseball::StateManager::createState(Baseball::State::S___0);
+    } else if (ctx.lastState->endInning()) {
+        ctx.currentState = ctx.createState(Baseball::State::S___0);
 
-        m_lastState->gameLink = m_currentState;
+        ctx.lastState->gameLink = ctx.currentState;
     // otherwise, the current state was created on the last play, so use it's link
     } else {
-        m_currentState = m_lastState->gameLink;
+        ctx.currentState = ctx.lastState->gameLink;
     }
 
-    if (!m_currentState) return false;
+    if (!ctx.currentState) return false;
 
     bool ok;
-    Baseball::Game::Instance curInst = m_curInstance;
+    Baseball::Game::Instance curInst = ctx.instance;
 
 
     // set the inning
-    m_currentState->inning = parts.at(0).toUInt(&ok);
-    m_curInstance.inning = m_currentState->inning;
+    ctx.currentState->inning = parts.at(1).toUInt(&ok);
+    ctx.instance.inning = ctx.currentState->inning;
     if (!ok) return false;
-    parts.pop_front();
 
     // the second field in the line specifies whether this is from a home
     // or visiting team, since we are storing this for both the game and the
     // batter (as well as fielders and baserunners), this field is not required.
-    parts.pop_front();
 
     // parse the batter
-    m_currentState->batter.tag = Baseball::player_tag(parts.at(0).toStdString());
-    Baseball::Game::Lineup::Card c = m_curGame->lineup.card(m_currentState->batter.tag);
+    ctx.currentState->batter.tag = Baseball::player_tag(parts.at(3).toStdString());
+    Baseball::Game::Lineup::Card c = ctx.game->lineup.card(ctx.currentState->batter.tag);
 
-    m_currentBatter = Baseball::Player::Table::get(m_currentState->batter.tag);
+    ctx.batter = ctx.player(ctx.currentState->batter.tag);
 
-    m_currentState->batter.position = c.position;
-    m_currentState->visiting = c.visiting;
-    parts.pop_front();
+    ctx.currentState->batter.position = c.position;
+    ctx.currentState->visiting = c.visiting;
 
 
     // parse count
-    if (parts.at(0).compare("??")) {
-        m_currentState->count = Baseball::Count::INVALID;
+    if (parts.at(4) != "??") {
+        ctx.currentState->count = Baseball::Count::INVALID;
     } else {
-        m_currentState->count.balls = parts.at(0).at(0).toLatin1() - '0';
-        m_currentState->count.strikes = parts.at(0).at(1).toLatin1() - '0';
+        ctx.currentState->count.balls = parts.at(4).at(0) - '0';
+        ctx.currentState->count.strikes = parts.at(4).at(1) - '0';
     }
-    parts.pop_front();
 
     // parse pitches
-    parsePlayPitches(parts.at(0));
-    parts.pop_front();
+    parsePlayPitches(ctx, parts.at(5));
 
     // setup
     Baseball::PositionRef pitcher;
     pitcher.position = Baseball::Pitcher;
-    pitcher.tag = m_curGame->lineup.find(pitcher.position,
-                                         !c.visiting,
-                                         curInst);
+    pitcher.tag = ctx.game->lineup.find(pitcher.position,
+                                        !c.visiting,
+                                        curInst);
 
-    m_currentPitcher = Baseball::Player::Table::get(pitcher.tag);
+    ctx.pitcher = ctx.player(pitcher.tag);
+    ctx.currentState->pitcher = pitcher;
 
     // parse the event of the play
-    parseEvent(parts.join(","));
+    parseEvent(ctx, parts.rest(6).toString());
 
 
 
-//    qDebug("%s", m_curInstance.baseOut.toString(m_currentState->inning).c_str());
-    m_currentState->gameLink = Baseball::StateManager::createState(m_curInstance.baseOut.state());
+//    qDebug("%s", ctx.instance.baseOut.toString(ctx.currentState->inning).c_str());
+    ctx.currentState->gameLink = ctx.createState(ctx.instance.baseOut.state());
 
     // if the last play was an end of inning, reset our state type
-    m_lastState = m_currentState;
+    ctx.lastState = ctx.currentState;
 
     return ret;
 }
@@ -626,17 +1015,17 @@ bool Parser::parsePlay(const QString& line)
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Parser::parsePlayPitches(const QString& pitches)
+void Parser::parsePlayPitches(ParseContext& ctx, const FieldRef& pitches)
 {
     bool runnerGoing = false;
     bool catcherPickoff = false;
     bool blocked = false;
 
-    m_currentState->pitches.clear();
+    ctx.currentState->pitches.clear();
 
     for (int i = 0; i < pitches.length(); i++) {
         Baseball::Pitch p;
-        char c = pitches.at(0).toLatin1();
+        char c = pitches.at(i);
         bool dontadd = false;
 
         // runner going
@@ -704,7 +1093,7 @@ void Parser::parsePlayPitches(const QString& pitches)
         }
 
         if (!dontadd) {
-            m_currentState->pitches.push_back(p);
+            ctx.currentState->pitches.push_back(p);
         }
     }
 }
@@ -713,7 +1102,7 @@ void Parser::parsePlayPitches(const QString& pitches)
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
-void Parser::parseEvent(const QString& eventString)
+void Parser::parseEvent(ParseContext& ctx, const QString& eventString)
 {
     QStringList al = eventString.split(".");
     QStringList dl = al.at(0).split("/");
@@ -724,107 +1113,157 @@ void Parser::parseEvent(const QString& eventString)
     QString adv;
     if (al.size() > 1) {
         adv = al.at(1);
-        parseEventAdv(adv);
+        parseEventAdv(ctx, adv);
     }
 
     QString ev = eventString;//dl.at(0);
-    parseEventEv(ev.remove(QRegExp("[#!]")));
+    parseEventEv(ctx, ev.remove(QChar('#')).remove(QChar('!')));
 
     if (dl.size() > 1) {
         dl.pop_front();
         desc = dl;
 
-        parseEventDesc(desc);
+        parseEventDesc(ctx, desc);
     }
 }
 
 #define CALL_MEMBER_FN(obj, pf) ((obj)->*(pf))
 
-int Parser::parseEventEv(const QString& evString)
+void Parser::initEvents()
 {
-    // events are parsed via regex.
+    // events are matched by the EventMatcher, which follows this table row
+    // for row.  The expressions themselves are only used to verify it.
     //  batting/fielding
     static const unsigned int PE_SIZE = 13;
 
-    static const ParseEvent pe[PE_SIZE] = {
+    static const struct {
+        const char* rx;
+        parseEvTypeFunc pf;
+    } pe[PE_SIZE] = {
     //   outs                   ([1-9?E]{0,8}[1-9](\([123B]\))?){1,3}
-        { QRegExp("([1-9]{0,8}[1-9](\\([123B]\\))?){1,3}"), &Parser::parseEvOut },
+        { "([1-9]{0,8}[1-9](\\([123B]\\))?){1,3}", &Parser::parseEvOut },
     //   hit                    ([SDT][1-9])|H[^P]R?(\([1-9]\))?
     //   ground rule double     DGR
-        { QRegExp("DGR([1-9])?|([SDT][1-9?]*)|H[^P]R?(\\([1-9]\\))?"), &Parser::parseEvHit },
+        { "DGR([1-9])?|([SDT][1-9?]*)|H[^P]R?(\\([1-9]\\))?", &Parser::parseEvHit },
     //   fielder's choice       FC([1-9?])?
-        { QRegExp("FC([1-9?])?"), &Parser::parseEvFC },
+        { "FC([1-9?])?", &Parser::parseEvFC },
     //   error                  E[1-9]|FLE[1-9]
-        { QRegExp("[1-9]{0,8}E[1-9]|FLE[1-9]"), &Parser::parseEvError },
+        { "[1-9]{0,8}E[1-9]|FLE[1-9]", &Parser::parseEvError },
     //   hit batter             HP
     //   interference           C/E[123]
-        { QRegExp("HP|C"), &Parser::parseEvBatter },
+        { "HP|C", &Parser::parseEvBatter },
     //   strikeout              K(23)?(\+(SB[23H]|CS[23H]|OA|PO[123H]|E[1-9]|WP|PB))?
-        { QRegExp("^K(.*)?"), &Parser::parseEvStrikeout },
+        { "^K(.*)?", &Parser::parseEvStrikeout },
     //   walk                   (IW?|W)(\+(SB[23H]|CS[23H]|OA|PO[123H]|E[1-9]|WP|PB))?
-        { QRegExp("^(IW?|W)(.*)?"), &Parser::parseEvWalk },
+        { "^(IW?|W)(.*)?", &Parser::parseEvWalk },
     //   no play                NP
-        { QRegExp("NP"), &Parser::parseEvIgnore },
+        { "NP", &Parser::parseEvIgnore },
     //  base running
     //   caught stealing        CS[23H]\([1-9]E?[1-9]\)
-        { QRegExp("(CS[23H](\\([1-9]{0,8}((E[1-9](/TH)?)|[1-9])\\))?(\\(UR\\))?;?)+"), &Parser::parseEvBaseRunning },
+        { "(CS[23H](\\([1-9]{0,8}((E[1-9](/TH)?)|[1-9])\\))?(\\(UR\\))?;?)+", &Parser::parseEvBaseRunning },
     //   defensive indifference DI
     //   other                  OA
     //   passed ball            PB
     //   wild pitch             WP
     //   balk                   BK
-        { QRegExp("BK|DI|OA|PB|WP"), &Parser::parseEvBaseRunning },
+        { "BK|DI|OA|PB|WP", &Parser::parseEvBaseRunning },
     //   pickoff                PO[123]\([1-9E]?[1-9]\)
     //   pickoff with CS        POCS[123]\([1-9]{2,4}\)
-        { QRegExp("PO[123]\\([1-9]{0,8}((E[1-9](/TH)?)|[1-9])\\)"), &Parser::parseEvBaseRunning },
-        { QRegExp("POCS[123H]\\([1-9]{0,8}((E[1-9](/TH)?)|[1-9])\\)"), &Parser::parseEvBaseRunning },
+        { "PO[123]\\([1-9]{0,8}((E[1-9](/TH)?)|[1-9])\\)", &Parser::parseEvBaseRunning },
+        { "POCS[123H]\\([1-9]{0,8}((E[1-9](/TH)?)|[1-9])\\)", &Parser::parseEvBaseRunning },
     //   stolen base            SB[23H]
-        { QRegExp("(((SB[23])|(SBH(\\(UR\\))?));?)+"), &Parser::parseEvBaseRunning }
+        { "(((SB[23])|(SBH(\\(UR\\))?));?)+", &Parser::parseEvBaseRunning }
     };
 
+    // the expressions are compiled per parser since QRegExp keeps its match
+    // state internally and cannot be shared between threads.  Only the
+    // verify mode uses them, so otherwise they are left empty.
+    m_events.clear();
+
+    for (unsigned int i = 0; i < PE_SIZE; i++) {
+        ParseEvent e = { (m_verifyEvents ? QRegExp(pe[i].rx) : QRegExp()), pe[i].pf };
+
+        m_events.push_back(e);
+    }
+}
+
+
+void Parser::setVerifyEvents(bool v)
+{
+    if (m_verifyEvents != v) {
+        m_verifyEvents = v;
+
+        initEvents();
+    }
+}
+
+int Parser::parseEventEv(ParseContext& ctx, const QString& evString)
+{
     // player assist/out/error string [1-9]{0,8}((E[1-9](/TH)?)|[1-9])
 
     // as we parse the play, we will determine the next state given our
-    // current state and the event which occured
-    int matched = 0;
+    // current state and the event which occured.  The matcher gives the
+    // same result as trying each row of the event table in order.
+    EventMatcher::Result m = EventMatcher::match(evString.utf16(), evString.size());
 
-    for (unsigned int i = 0; i < PE_SIZE; i++) {
-        if (pe[i].r.indexIn(evString) == 0) {
-            matched = pe[i].r.matchedLength();
-            CALL_MEMBER_FN(this, pe[i].pf)(evString.left(matched));
-            break;
-        }
+    if (m_verifyEvents) {
+        verifyEvent(ctx, evString, m.type, m.length);
     }
 
-    if (!matched) {
+    if (m.type != EventMatcher::NoMatch) {
+        CALL_MEMBER_FN(this, m_events[m.type - 1].pf)(ctx, evString.left(m.length));
+    } else {
         qDebug("%s [%d]: unmatched string `%s'",
-               m_fileName.toStdString().c_str(),
-               m_lineNumber,
+               ctx.fileName.toStdString().c_str(),
+               ctx.lineNumber,
                evString.toStdString().c_str());
     }
 
-    return matched;
+    return m.length;
 }
 
 
-void Parser::parseEventDesc(const QStringList& descList)
+void Parser::verifyEvent(ParseContext& ctx, const QString& evString, int type, int length)
 {
+    int rxType = EventMatcher::NoMatch;
+    int rxLength = 0;
+
+    for (unsigned int i = 0; i < m_events.size(); i++) {
+        if (m_events[i].r.indexIn(evString) == 0) {
+            rxType = i + 1;
+            rxLength = m_events[i].r.matchedLength();
+            break;
+        }
+    }
+
+    if ((rxType != type) || (rxLength != length)) {
+        qWarning("%s [%d]: event `%s' matched as %s (%d), expected %s (%d)",
+                 ctx.fileName.toStdString().c_str(),
+                 ctx.lineNumber,
+                 evString.toStdString().c_str(),
+                 EventMatcher::name(static_cast<EventMatcher::Class>(type)), length,
+                 EventMatcher::name(static_cast<EventMatcher::Class>(rxType)), rxLength);
+
+        ctx.mismatches++;
+    }
+}
+
 
+void Parser::parseEventDesc(ParseContext& ctx, const QStringList& descList)
+{
+    Q_UNUSED(ctx);
+    Q_UNUSED(descList);
 }
 
 
-void Parser::parseEventAdv(const QString& advString)
+void Parser::parseEventAdv(ParseContext& ctx, const QString& advString)
 {
     // the advance field can be parsed with:
     //    [B123][-X][123H](\(([1-9]{0,8}((E[1-9](/TH[123H]?)?)|[1-9])|TH[1-9]?|NR|UR|NORBI|RBI|WP|[1-9]/INT)\))*
     QStringList advList = advString.split(";");
 
-    Baseball::Player::Record::TeamYear tybat(m_curGame->year,
-        (m_currentState->visiting ? m_curGame->teamVisiting : m_curGame->teamHome));
-    Baseball::Player::Record::TeamYear tyfield(m_curGame->year,
-        (m_currentState->visiting ? m_curGame->teamHome : m_curGame->teamVisiting));
-
-    static int cnt = 0;
+    bool batVisiting = ctx.currentState->visiting;
+    bool fieldVisiting = !ctx.currentState->visiting;
 
     for (int i = 0; i < advList.size(); i++) {
         QString sz = advList.at(i);
@@ -838,14 +1277,14 @@ void Parser::parseEventAdv(const QString& advString)
         bool th = false;
         bool err = false;
 
-        QRegExp rx("[B123][-X][123H]");
+        int length = 0;
         Baseball::Advance advance;
 
         // the first part of each advance is the actual base advancement
         // an '-' indicates that base was successfully taken.  An 'X' means
         // the runner is out at that base.
-        if (rx.indexIn(sz) == 0) {
-            std::string s = sz.left(rx.matchedLength()).toStdString();
+        if (EventMatcher::findAdvance(sz.utf16(), sz.size(), 0, length) == 0) {
+            std::string s = sz.left(length).toStdString();
             Baseball::Out o;
 
             Baseball::Base from = Baseball::Parse<Baseball::Base>(std::string(1, s.at(0)));
@@ -853,7 +1292,7 @@ void Parser::parseEventAdv(const QString& advString)
             bool out = (s.at(1) == 'X' ? true : false);
 
             if (out) {
-                m_curInstance.baseOut.runner(from, true);
+                ctx.instance.baseOut.runner(from, true);
 
                 // create an Out for this state
 
@@ -865,11 +1304,11 @@ void Parser::parseEventAdv(const QString& advString)
                 advance[from] = to;
 
                 // update our instance
-                m_curInstance.baseOut.advance(advance);
+                ctx.instance.baseOut.advance(advance);
             }
 
-            if (sz.length() > rx.matchedLength()) {
-                QString p = sz.right(sz.length() - rx.matchedLength());
+            if (sz.length() > length) {
+                QString p = sz.right(sz.length() - length);
 
                 // parse extra fields
                 ur = p.contains("(UR)");
@@ -882,35 +1321,35 @@ void Parser::parseEventAdv(const QString& advString)
             {
                 if ((rbi) ||
                     ((!err) && (!norbi))) {
-                    if (m_currentBatter) {
-                        m_currentBatter->year(tybat).batting.RBI++;
+                    if (ctx.batter) {
+                        ctx.credit(ctx.batter, batVisiting, Baseball::Stat::BattingRBI);
                     }
                 }
 
                 if (!ur) {
-                    if (m_currentPitcher) {
-                        m_currentPitcher->year(tyfield).pitching.ER++;
+                    if (ctx.pitcher) {
+                        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingER);
                     }
                 }
 
                 // give player a R
 
-                m_currentState->event.runsScored++;
+                ctx.currentState->event.runsScored++;
             }
 
             if (wp) {
-                if (m_currentPitcher) {
-                    m_currentPitcher->year(tyfield).pitching.WP++;
+                if (ctx.pitcher) {
+                    ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingWP);
                 }
             }
 
             // push out/advance
             if (out) {
-                incrementOuts();
-                m_currentState->event.outs.push_back(o);
+                incrementOuts(ctx);
+                ctx.currentState->event.outs.push_back(o);
             }
 
-            m_currentState->event.advance |= advance;
+            ctx.currentState->event.advance |= advance;
         }
     }
 }
@@ -919,19 +1358,7 @@ void Parser::parseEventAdv(const QString& advString)
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
-// returns true if the regex given is matched at the beginning of sz
-static bool regexMatch(const QString& regex, const QString& sz)
-{
-    QRegExp rx(regex);
-
-    if (rx.indexIn(sz) == 0) {
-        return true;
-    }
-
-    return false;
-}
-
-void Parser::parseEvOut(const QString& ev)
+void Parser::parseEvOut(ParseContext& ctx, const QString& ev)
 {
     // the basic form for outs is as follows
     //  [1-9]{1,4}(\([123B]\))?
@@ -945,26 +1372,25 @@ void Parser::parseEvOut(const QString& ev)
     // The second part of the sequence is an operational base number surrounded
     // by parantheses.  This number represents the base of the baserunner being
     // put out.
-    QRegExp rx("([1-9]{0,8}[1-9](\\([123B]\\))?)");
     int rc = 0;
+    int length = 0;
 
-    Baseball::Game::Instance preEventInst(Baseball::BaseOut(m_currentState->type),
-                                          m_currentState->inning,
-                                          m_currentState->runsScored());
+    Baseball::Game::Instance preEventInst(Baseball::BaseOut(ctx.currentState->type),
+                                          ctx.currentState->inning,
+                                          ctx.currentState->runsScored());
 
-    Baseball::Player::Record::TeamYear tyfield(m_curGame->year,
-        (m_currentState->visiting ? m_curGame->teamHome : m_curGame->teamVisiting));
+    bool fieldVisiting = !ctx.currentState->visiting;
 
-    if (m_currentPitcher) {
-        m_currentPitcher->year(tyfield).pitching.BFP++;
+    if (ctx.pitcher) {
+        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingBFP);
     }
 
     // set the event here to out
-    m_currentState->event.type = Baseball::Event::O;
+    ctx.currentState->event.type = Baseball::Event::O;
 
-    while ((rc = rx.indexIn(ev, rc)) != -1) {
-        QString s = ev.mid(rc, rx.matchedLength());
-        rc += rx.matchedLength();
+    while ((rc = EventMatcher::findOut(ev.utf16(), ev.size(), rc, length)) != -1) {
+        QString s = ev.mid(rc, length);
+        rc += length;
 
         bool exBase = false;
         bool error = false;
@@ -990,52 +1416,52 @@ void Parser::parseEvOut(const QString& ev)
                     // error
                     Baseball::PositionRef p;
                     p.position = Baseball::Parse<Baseball::Position>(std::string(1, c));
-                    p.tag = m_curGame->lineup.find(p.position,
-                                                   !m_currentState->visiting,
-                                                   preEventInst);
+                    p.tag = ctx.game->lineup.find(p.position,
+                                                  !ctx.currentState->visiting,
+                                                  preEventInst);
 
                     o.out.position = Baseball::NoPosition;
-                    Baseball::Player::Record *rec = Baseball::Player::Table::get(p.tag);
+                    Baseball::Player::Record *rec = ctx.player(p.tag);
 
                     // update event type
-                    m_currentState->event.type = Baseball::Event::E;
+                    ctx.currentState->event.type = Baseball::Event::E;
 
                     if (rec) {
-                        rec->year(tyfield).fielding.E++;
+                        ctx.credit(rec, fieldVisiting, Baseball::Stat::FieldingE);
                     }
                 } else if (((i + 1) >= s.length()) || (s.at(i + 1).toLatin1() == '(')) {
                     // out
                     o.out.position = Baseball::Parse<Baseball::Position>(std::string(1, c));
-                    o.out.tag = m_curGame->lineup.find(o.out.position,
-                                                       !m_currentState->visiting,
-                                                       preEventInst);
+                    o.out.tag = ctx.game->lineup.find(o.out.position,
+                                                      !ctx.currentState->visiting,
+                                                      preEventInst);
 
-                    Baseball::Player::Record *rec = Baseball::Player::Table::get(o.out.tag);
+                    Baseball::Player::Record *rec = ctx.player(o.out.tag);
 
                     if (rec) {
                         // record the statistical put out
-                        rec->year(tyfield).fielding.PO++;
+                        ctx.credit(rec, fieldVisiting, Baseball::Stat::FieldingPO);
                     }
 
-                    incrementOuts();
+                    incrementOuts(ctx);
 
-                    if (m_currentPitcher) {
-                        m_currentPitcher->year(tyfield).pitching.IP++;
+                    if (ctx.pitcher) {
+                        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingIP);
                     }
                 } else {
                     // assist
                     Baseball::PositionRef r;
                     r.position = Baseball::Parse<Baseball::Position>(std::string(1, c));
-                    r.tag = m_curGame->lineup.find(r.position,
-                                                   !m_currentState->visiting,
-                                                   preEventInst);
+                    r.tag = ctx.game->lineup.find(r.position,
+                                                  !ctx.currentState->visiting,
+                                                  preEventInst);
                     o.assists.push_back(r);
                     o.unassisted = false;
 
-                    Baseball::Player::Record *rec = Baseball::Player::Table::get(r.tag);
+                    Baseball::Player::Record *rec = ctx.player(r.tag);
 
                     if (rec) {
-                        rec->year(tyfield).fielding.A++;
+                        ctx.credit(rec, fieldVisiting, Baseball::Stat::FieldingA);
                     }
                 }
 
@@ -1049,119 +1475,117 @@ void Parser::parseEvOut(const QString& ev)
 
         o.base = b;
 
-        m_currentState->event.outs.push_back(o);
+        ctx.currentState->event.outs.push_back(o);
     }
 }
 
 
-void Parser::parseEvHit(const QString& ev)
+void Parser::parseEvHit(ParseContext& ctx, const QString& ev)
 {
-    Baseball::Player::Record::TeamYear tyfield(m_curGame->year,
-        (m_currentState->visiting ? m_curGame->teamHome : m_curGame->teamVisiting));
+    bool fieldVisiting = !ctx.currentState->visiting;
 
-    Baseball::Player::Record::TeamYear tybat(m_curGame->year,
-        (m_currentState->visiting ? m_curGame->teamVisiting : m_curGame->teamHome));
+    bool batVisiting = ctx.currentState->visiting;
 
-    if (m_currentPitcher) {
-        m_currentPitcher->year(tyfield).pitching.BFP++;
-        m_currentPitcher->year(tyfield).pitching.H++;
+    if (ctx.pitcher) {
+        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingBFP);
+        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingH);
     }
 
-    if (regexMatch("H[^P]R?(\\([1-9]\\))?", ev)) {
-        m_currentBatter->year(tybat).batting.HR++;
-        m_currentBatter->year(tybat).batting.RBI++;
+    // a home run, H[^P]R?(\([1-9]\))?
+    if ((ev.size() >= 2) && (ev.at(0).toLatin1() == 'H') && (ev.at(1).toLatin1() != 'P')) {
+        ctx.credit(ctx.batter, batVisiting, Baseball::Stat::BattingHR);
+        ctx.credit(ctx.batter, batVisiting, Baseball::Stat::BattingRBI);
 
         Baseball::Advance adv;
         adv[Baseball::Batter] = Baseball::Home;
 
-        m_currentState->event.advance |= adv;
+        ctx.currentState->event.advance |= adv;
     }
 }
 
 
-void Parser::parseEvFC(const QString& ev)
+void Parser::parseEvFC(ParseContext& ctx, const QString& ev)
 {
-    Baseball::Game::Instance preEventInst(Baseball::BaseOut(m_currentState->type),
-                                          m_currentState->inning,
-                                          m_currentState->runsScored());
+    Baseball::Game::Instance preEventInst(Baseball::BaseOut(ctx.currentState->type),
+                                          ctx.currentState->inning,
+                                          ctx.currentState->runsScored());
 
-    Baseball::Player::Record::TeamYear tyfield(m_curGame->year,
-        (m_currentState->visiting ? m_curGame->teamHome : m_curGame->teamVisiting));
+    bool fieldVisiting = !ctx.currentState->visiting;
 
-    incrementOuts();
+    incrementOuts(ctx);
 
-    if (m_currentPitcher) {
-        m_currentPitcher->year(tyfield).pitching.IP++;
-        m_currentPitcher->year(tyfield).pitching.BFP++;
+    if (ctx.pitcher) {
+        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingIP);
+        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingBFP);
     }
 
-    m_currentState->event.type = Baseball::Event::FC;
+    ctx.currentState->event.type = Baseball::Event::FC;
 
-    QRegExp rx("[1-9]{0,8}((E[1-9](/TH[1-9]?)?)|[1-9])");
     int rc = 0;
+    int length = 0;
 
-    if ((rc = rx.indexIn(ev)) != -1) {
-        QString s = ev.mid(rc, rx.matchedLength());
+    if ((rc = EventMatcher::findFielders(ev.utf16(), ev.size(), 0, length)) != -1) {
+        QString s = ev.mid(rc, length);
         Baseball::PositionRef errPos;
 
-        parseOutString(s, &errPos);
+        parseOutString(ctx, s, &errPos);
     }
 }
 
 
-void Parser::parseEvError(const QString& ev)
+void Parser::parseEvError(ParseContext& ctx, const QString& ev)
 {
-
+    Q_UNUSED(ctx);
+    Q_UNUSED(ev);
 }
 
 
-void Parser::parseEvBatter(const QString& ev)
+void Parser::parseEvBatter(ParseContext& ctx, const QString& ev)
 {
-
+    Q_UNUSED(ctx);
+    Q_UNUSED(ev);
 }
 
 
-void Parser::parseEvWalk(const QString& ev)
+void Parser::parseEvWalk(ParseContext& ctx, const QString& ev)
 {
-    Baseball::Player::Record::TeamYear tybat(m_curGame->year,
-        (m_currentState->visiting ? m_curGame->teamVisiting : m_curGame->teamHome));
+    bool batVisiting = ctx.currentState->visiting;
 
-    if (m_currentBatter) {
-        m_currentBatter->year(tybat).batting.BB++;
+    if (ctx.batter) {
+        ctx.credit(ctx.batter, batVisiting, Baseball::Stat::BattingBB);
     }
 
-    m_currentState->event.type = Baseball::Event::W;
+    ctx.currentState->event.type = Baseball::Event::W;
 
     // check for a batter advance, if we have one, ignore the walk advance
-    if (m_currentState->event.advance[Baseball::Batter] == Baseball::NoBase) {
+    if (ctx.currentState->event.advance[Baseball::Batter] == Baseball::NoBase) {
         Baseball::Advance a;
         a[Baseball::Batter] = Baseball::First;
 
-        m_currentState->event.advance |= a;
-        m_curInstance.baseOut.advance(a);
+        ctx.currentState->event.advance |= a;
+        ctx.instance.baseOut.advance(a);
     }
 }
 
 
-void Parser::parseEvStrikeout(const QString& ev)
+void Parser::parseEvStrikeout(ParseContext& ctx, const QString& ev)
 {
-    Baseball::Game::Instance preEventInst(Baseball::BaseOut(m_currentState->type),
-                                          m_currentState->inning,
-                                          m_currentState->runsScored());
+    Baseball::Game::Instance preEventInst(Baseball::BaseOut(ctx.currentState->type),
+                                          ctx.currentState->inning,
+                                          ctx.currentState->runsScored());
 
-    Baseball::Player::Record::TeamYear tyfield(m_curGame->year,
-        (m_currentState->visiting ? m_curGame->teamHome : m_curGame->teamVisiting));
+    bool fieldVisiting = !ctx.currentState->visiting;
 
     bool matched = false;
 
-    incrementOuts();
-    m_currentState->event.type = Baseball::Event::K;
+    incrementOuts(ctx);
+    ctx.currentState->event.type = Baseball::Event::K;
 
     // K([1-9E][1-9])?(\+(DI|OA|PB|WP|BK|stolen base|caught stealing|pickoffs)?
-    if (m_currentPitcher) {
-        m_currentPitcher->year(tyfield).pitching.SO++;
-        m_currentPitcher->year(tyfield).pitching.IP++;
-        m_currentPitcher->year(tyfield).pitching.BFP++;
+    if (ctx.pitcher) {
+        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingSO);
+        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingIP);
+        ctx.credit(ctx.pitcher, fieldVisiting, Baseball::Stat::PitchingBFP);
     }
 
     // if we have a ($$) value, we should attribute the assist and PO to the given numbers,
@@ -1182,7 +1606,7 @@ void Parser::parseEvStrikeout(const QString& ev)
 
     for (unsigned int i = 0; i < BR_SIZE; i++) {
         if (pe[i].r.exactMatch(ev)) {
-            CALL_MEMBER_FN(this, pe[i].pf)(ev);
+            CALL_MEMBER_FN(this, pe[i].pf)(ctx, ev);
             matched = true;
             break;
         }
@@ -1195,14 +1619,16 @@ void Parser::parseEvStrikeout(const QString& ev)
 }
 
 
-void Parser::parseEvBaseRunning(const QString& ev)
+void Parser::parseEvBaseRunning(ParseContext& ctx, const QString& ev)
 {
-
+    Q_UNUSED(ctx);
+    Q_UNUSED(ev);
 }
 
 
-void Parser::parseEvIgnore(const QString& ev)
+void Parser::parseEvIgnore(ParseContext& ctx, const QString& ev)
 {
+    Q_UNUSED(ctx);
     Q_UNUSED(ev);
 }
 
@@ -1210,13 +1636,13 @@ void Parser::parseEvIgnore(const QString& ev)
 //                                                                           //
 ///////////////////////////////////////////////////////////////////////////////
 
-Baseball::Out Parser::parseOutString(const QString& sz, Baseball::PositionRef* error)
+Baseball::Out Parser::parseOutString(ParseContext& ctx, const QString& sz, Baseball::PositionRef* error)
 {
     Baseball::Out ret;
 
-    Baseball::Game::Instance preEventInst(Baseball::BaseOut(m_currentState->type),
-                                          m_currentState->inning,
-                                          m_currentState->runsScored());
+    Baseball::Game::Instance preEventInst(Baseball::BaseOut(ctx.currentState->type),
+                                          ctx.currentState->inning,
+                                          ctx.currentState->runsScored());
 
     // [1-9]{0,8}((E[1-9](/TH[123H]?)?)|[1-9])
     bool err = false;
@@ -1237,9 +1663,9 @@ Baseball::Out Parser::parseOutString(const QString& sz, Baseball::PositionRef* e
             if ((c >= '1') && (c <= '9')) {
                 if ((tcheck < 3) && (error)) {
                     error->position = Baseball::Parse<Baseball::Position>(std::string(1, c));
-                    error->tag = m_curGame->lineup.find(error->position,
-                                                        !m_currentState->visiting,
-                                                        preEventInst);
+                    error->tag = ctx.game->lineup.find(error->position,
+                                                       !ctx.currentState->visiting,
+                                                       preEventInst);
                 }
             } else if (((c == '/') && (tcheck == 0)) ||
                        ((c == 'T') && (tcheck == 1))) {
@@ -1254,12 +1680,12 @@ Baseball::Out Parser::parseOutString(const QString& sz, Baseball::PositionRef* e
             if ((i + 1) == sz.length()) {
                 // out
                 ret.out.position = Baseball::Parse<Baseball::Position>(std::string(1, c));
-                ret.out.tag = m_curGame->lineup.find(ret.out.position,
-                                                     !m_currentState->visiting,
-                                                     preEventInst);
+                ret.out.tag = ctx.game->lineup.find(ret.out.position,
+                                                    !ctx.currentState->visiting,
+                                                    preEventInst);
 
                 ret.base = Baseball::Batter;
-                Baseball::BaseOut bo(m_currentState->type);
+                Baseball::BaseOut bo(ctx.currentState->type);
 
                 if (!ret.unassisted) {
                     switch (ret.out.position) {
@@ -1283,9 +1709,9 @@ Baseball::Out Parser::parseOutString(const QString& sz, Baseball::PositionRef* e
                 // assist
                 Baseball::PositionRef a;
                 a.position = Baseball::Parse<Baseball::Position>(std::string(1, c));
-                a.tag = m_curGame->lineup.find(a.position,
-                                               !m_currentState->visiting,
-                                               preEventInst);
+                a.tag = ctx.game->lineup.find(a.position,
+                                              !ctx.currentState->visiting,
+                                              preEventInst);
                 ret.assists.push_back(a);
                 ret.unassisted = false;
             }
@@ -1295,11 +1721,11 @@ Baseball::Out Parser::parseOutString(const QString& sz, Baseball::PositionRef* e
     return ret;
 }
 
-void Parser::incrementOuts()
+void Parser::incrementOuts(ParseContext& ctx)
 {
-    m_curInstance.baseOut.outs++;
+    ctx.instance.baseOut.outs++;
 
-    if (m_curInstance.baseOut.outs >= 3) {
-        m_curInstance.baseOut.reset();
+    if (ctx.instance.baseOut.outs >= 3) {
+        ctx.instance.baseOut.reset();
     }
 }
@@ -26,29 +26,81 @@
 #include <QRegExp>
 #include <QList>
 #include <QDir>
+#include <QByteArray>
 
 #include "sabre_output.h"
 
 #include "baseball.h"
+#include "parse_context.h"
+
+#include <vector>
+#include <algorithm>
+
+class ParseBatch;
+class ParsePipeline;
+class FieldRef;
+class FieldList;
 
 class Parser : public QObject
 {
     Q_OBJECT
 
+    friend class ParseWorker;
+    friend class ParsePipeline;
+    friend class GameLoader;
+
 public:
-    Parser(const QString& dbPath, Sabre::Output* out) :
-        m_output(out),
-        m_dbPath(dbPath),
-        m_curGame(NULL),
-        m_lastState(NULL),
-        m_currentState(NULL) {}
+    Parser(const QString& dbPath, Sabre::Output* out);
+    ~Parser();
+
+    // limits parsing to the given years, an empty list is every year.  The
+    // years are kept in the manifest so that a refresh keeps to them.
+    void restrictYears(const QList<int>& years)
+    {
+        m_years = years;
+
+        // yearRestricted expects them in order
+        std::sort(m_years.begin(), m_years.end());
+    }
+
+    // sets the number of threads used to parse event files.  With a single
+    // worker (the default) every file is parsed on the calling thread,
+    // otherwise files go through a ParsePipeline.
+    void setWorkerCount(int n) { m_workers = std::max(1, n); }
 
-    void restrictYears(const QList<int>& years) { m_years = years; }
+    // when set, every event is also matched against the event regex table
+    // and any difference from the EventMatcher is reported.  This is used to
+    // check the matcher against a corpus of event files.  The table belongs
+    // to the parser, so a verifying parser parses one file at a time.
+    void setVerifyEvents(bool v);
+
+    unsigned int eventMismatches() const { return m_eventMismatches; }
+
+    // when set, the plays of event files are not kept.  Files are still
+    // parsed for the statistics of their games, but the games are created
+    // as stubs holding their place in the file, and their plays are parsed
+    // again by a GameLoader when first used.
+    void setLazyGames(bool lazy) { m_lazyGames = lazy; }
+
+    // the snapshot written after a parse of this database
+    QString snapshotPath() const;
+
+    static const char* SNAPSHOT_FILE;
 
 public slots:
 
     void parse();
 
+    // loads the tables from the snapshot of this database instead of
+    // parsing it
+    void load();
+
+    // re-parses the files which were added or changed since the tables
+    // were built, as recorded in the manifest.  The games and statistics
+    // of a changed or removed event file are taken out of the tables
+    // first.  If there is no manifest the whole database is parsed.
+    void refresh();
+
 signals:
 
     void finished();
@@ -69,41 +121,79 @@ protected:
 
     // parse files
     bool parseRosters(const QDir& path);
+    bool parseRoster(const QString& fileName, int year);
     bool parseTeams(const QDir& path);
     bool parseGameData(const QDir& d, const QDate& y);
+    bool parseGameFiles(const QStringList& files, int year);
 
-    // parse lines
-    bool parseFile(const QString& fileName, int year);
+    // creates a stub for every game of fileName and logs its statistics,
+    // see setLazyGames
+    bool indexGameFile(const QString& fileName, int year);
 
-    bool parseInfo(const QStringList& info);
-    bool parsePlay(const QString& line);
-    bool parseSub(const QString& line);
+    // logs the throughput of the pipeline stages, if a pipeline was used,
+    // and starts a new pipeline for the next parse
+    void reportPipeline();
 
-    void parsePlayPitches(const QString& pitches);
+    // commits a batch parsed from fileName, recording what it produced and
+    // the hash of the contents it was parsed from in the manifest
+    void commitBatch(const QString& fileName, ParseBatch& batch, const QByteArray& hash);
 
-    void parseEvent(const QString& eventString);
+    // folds the statistics of the games committed since the last call into
+    // the player table
+    void reduceStats();
 
-    int parseEventEv(const QString& evString);
-    void parseEventDesc(const QStringList& descList);
-    void parseEventAdv(const QString& advString);
+    // manifest entries are keyed by the path of a file relative to the
+    // database root
+    QString relativePath(const QString& fileName) const;
+
+    // records the size, time and hash of fileName in a new manifest entry.
+    // The hash is read from the file unless the caller already has it.
+    Baseball::Manifest::Entry* stampFile(const QString& fileName);
+    Baseball::Manifest::Entry* stampFile(const QString& fileName, const QByteArray& hash);
+
+    // returns true if fileName is not in the manifest or its contents
+    // differ from the recorded hash
+    bool fileChanged(const QString& fileName);
+
+    static QByteArray fileHash(const QString& fileName);
+
+    // parse lines.  Everything which changes while parsing a file is kept
+    // in its ParseContext.  parseFile returns false if the file could not
+    // be opened, and sets hash to the digest of the file when given.
+    bool parseFile(ParseContext& ctx, int year, QByteArray* hash = NULL);
+    void parseRecords(ParseContext& ctx, int year, const std::vector<FieldList>& records);
+    void parseRecord(ParseContext& ctx, const FieldList& chunks, int year);
+
+    bool parseInfo(ParseContext& ctx, const FieldList& info);
+    bool parsePlay(ParseContext& ctx, const FieldList& parts);
+    bool parseSub(ParseContext& ctx, const FieldList& parts);
+
+    void parsePlayPitches(ParseContext& ctx, const FieldRef& pitches);
+
+    void parseEvent(ParseContext& ctx, const QString& eventString);
+
+    int parseEventEv(ParseContext& ctx, const QString& evString);
+    void verifyEvent(ParseContext& ctx, const QString& evString, int type, int length);
+    void parseEventDesc(ParseContext& ctx, const QStringList& descList);
+    void parseEventAdv(ParseContext& ctx, const QString& advString);
 
 private:
 
-    typedef void (Parser::*parseEvTypeFunc)(const QString&);
+    typedef void (Parser::*parseEvTypeFunc)(ParseContext&, const QString&);
 
     struct ParseEvent {
         QRegExp r;
         parseEvTypeFunc pf;
     };
 
-    void parseEvOut(const QString& ev);
-    void parseEvHit(const QString& ev);
-    void parseEvFC(const QString& ev);
-    void parseEvError(const QString& ev);
-    void parseEvBatter(const QString& ev);
-    void parseEvWalk(const QString& ev);
-    void parseEvStrikeout(const QString& ev);
-    void parseEvBaseRunning(const QString& ev);
+    void parseEvOut(ParseContext& ctx, const QString& ev);
+    void parseEvHit(ParseContext& ctx, const QString& ev);
+    void parseEvFC(ParseContext& ctx, const QString& ev);
+    void parseEvError(ParseContext& ctx, const QString& ev);
+    void parseEvBatter(ParseContext& ctx, const QString& ev);
+    void parseEvWalk(ParseContext& ctx, const QString& ev);
+    void parseEvStrikeout(ParseContext& ctx, const QString& ev);
+    void parseEvBaseRunning(ParseContext& ctx, const QString& ev);
 
     // This operation parses a string containing a single out.  If this
     // string contains an error, and the error variable is set to a valid
@@ -120,25 +210,34 @@ private:
     //
     // If the base could be determined based on the above criterion, then
     // tagOut will be set if there is no force at that base.
-    Baseball::Out parseOutString(const QString& sz,
+    Baseball::Out parseOutString(ParseContext& ctx, const QString& sz,
                                  Baseball::PositionRef* error = NULL);
 
-    void parseEvIgnore(const QString& ev);
+    void parseEvIgnore(ParseContext& ctx, const QString& ev);
+
+    void incrementOuts(ParseContext& ctx);
 
-    void incrementOuts();
+    void initEvents();
 
     QList<int> m_years;
     QDir m_dbPath;
 
-    QString m_fileName;
-    unsigned int m_lineNumber;
+    int m_workers;
+
+    // the pipeline used for event files when there is more than one
+    // worker, kept for the whole parse so its report covers every year
+    ParsePipeline* m_pipeline;
+
+    // committed games whose statistics are not in the player table yet
+    std::vector<Baseball::Game::Record*> m_unreduced;
 
-    Baseball::Game::Record* m_curGame;
-    Baseball::Game::Instance m_curInstance;
+    // event patterns, QRegExp keeps match state so each parser has a copy.
+    // Row i holds the handler for EventMatcher class i + 1.  The patterns
+    // are only compiled in verify mode.
+    std::vector<ParseEvent> m_events;
 
-    Baseball::StateLink m_lastState;
-    Baseball::StateLink m_currentState;
+    bool m_verifyEvents;
+    unsigned int m_eventMismatches;
 
-    Baseball::Player::Record* m_currentBatter;
-    Baseball::Player::Record* m_currentPitcher;
+    bool m_lazyGames;
 };
@@ -0,0 +1,143 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "parse_context.h"
+#include "parse_worker.h"
+
+ParseContext::ParseContext(const QString& file, ParseBatch* b) :
+    fileName(file),
+    lineNumber(1),
+    batch(b),
+    game(NULL),
+    lastState(NULL),
+    currentState(NULL),
+    batter(NULL),
+    pitcher(NULL),
+    mismatches(0)
+{
+    m_teams[0] = NO_INDEX;
+    m_teams[1] = NO_INDEX;
+}
+
+
+void ParseContext::beginGame(Baseball::Game::Record* g)
+{
+    game = g;
+    instance = Baseball::Game::Instance::STARTER;
+
+    // every game starts its own state chain
+    lastState = NULL;
+    currentState = NULL;
+
+    batter = NULL;
+    pitcher = NULL;
+
+    m_resolved.clear();
+    m_teams[0] = NO_INDEX;
+    m_teams[1] = NO_INDEX;
+}
+
+
+Baseball::Game::Record* ParseContext::createGame(const Baseball::game_tag& t)
+{
+    if (batch) {
+        return batch->createGame(t);
+    }
+
+    return Baseball::Game::Table::createRecord(t);
+}
+
+
+Baseball::StateLink ParseContext::createState(const Baseball::State::Type& t)
+{
+    if (batch) {
+        return batch->createState(t);
+    }
+
+    return Baseball::StateManager::createState(t);
+}
+
+
+Baseball::Player::Record* ParseContext::player(const Baseball::player_tag& t)
+{
+    for (unsigned int i = 0; i < m_resolved.size(); i++) {
+        if (m_resolved[i].key == t.key) {
+            return m_resolved[i].record;
+        }
+    }
+
+    Resolved r;
+
+    r.key = t.key;
+    r.record = (batch ? batch->player(t) : Baseball::Player::Table::get(t));
+    r.logIndex = NO_INDEX;
+
+    // players missing from the table are remembered too, so that they are
+    // not looked up again
+    m_resolved.push_back(r);
+
+    return r.record;
+}
+
+
+unsigned int ParseContext::logIndex(const Baseball::Player::Record* p)
+{
+    for (unsigned int i = 0; i < m_resolved.size(); i++) {
+        if (m_resolved[i].record == p) {
+            if (m_resolved[i].logIndex == NO_INDEX) {
+                m_resolved[i].logIndex = game->stats.playerIndex(p->id());
+            }
+
+            return m_resolved[i].logIndex;
+        }
+    }
+
+    return game->stats.playerIndex(p->id());
+}
+
+
+unsigned int ParseContext::teamIndex(bool visiting)
+{
+    unsigned int& t = m_teams[visiting ? 0 : 1];
+
+    // the teams are known once the info lines are read, which come before
+    // any start line
+    if (t == NO_INDEX) {
+        t = game->stats.teamIndex(Baseball::Player::Record::TeamYear(
+            game->year, (visiting ? game->teamVisiting : game->teamHome)));
+    }
+
+    return t;
+}
+
+
+void ParseContext::credit(const Baseball::Player::Record* p, bool visiting, Baseball::Stat::Id id)
+{
+    if ((p) && (game)) {
+        game->stats.add(logIndex(p), teamIndex(visiting), id);
+    }
+}
+
+
+void ParseContext::appear(const Baseball::Player::Record* p, bool visiting)
+{
+    if ((p) && (game)) {
+        game->stats.appear(logIndex(p), teamIndex(visiting));
+    }
+}
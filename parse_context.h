@@ -0,0 +1,102 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QString>
+
+#include <vector>
+
+#include "baseball.h"
+
+class ParseBatch;
+
+// A ParseContext holds everything which changes while a single file is
+// parsed: where in the file the parser is, the game and state being built,
+// and the batter and pitcher of the current play.  Each file gets its own
+// context, so one Parser can parse several files at once as long as each
+// goes into its own batch.
+struct ParseContext
+{
+    ParseContext(const QString& file, ParseBatch* b = NULL);
+
+    // starts parsing the game g, forgetting everything resolved for the
+    // game before
+    void beginGame(Baseball::Game::Record* g);
+
+    // record access used while parsing game data.  When the context fills a
+    // batch these refer to the batch, otherwise they refer to the global
+    // tables.
+    Baseball::Game::Record* createGame(const Baseball::game_tag& t);
+    Baseball::StateLink createState(const Baseball::State::Type& t);
+
+    // returns the record of player t.  Players are resolved once a game,
+    // normally at their start or sub line, and found in the game's cache
+    // after that.
+    Baseball::Player::Record* player(const Baseball::player_tag& t);
+
+    // logs a change to the statistics of p, who plays for the visiting
+    // team if visiting is set, in the current game.  Nothing is logged if
+    // p is NULL.
+    void credit(const Baseball::Player::Record* p, bool visiting, Baseball::Stat::Id id);
+
+    // logs that p played for the visiting or home team in the current game
+    void appear(const Baseball::Player::Record* p, bool visiting);
+
+    QString fileName;
+    unsigned int lineNumber;
+
+    // when set, game data is parsed into this batch instead of the tables
+    ParseBatch* batch;
+
+    Baseball::Game::Record* game;
+    Baseball::Game::Instance instance;
+
+    Baseball::StateLink lastState;
+    Baseball::StateLink currentState;
+
+    Baseball::Player::Record* batter;
+    Baseball::Player::Record* pitcher;
+
+    // events which the EventMatcher and the event regex table disagreed on
+    unsigned int mismatches;
+
+private:
+
+    // a player of the current game, with its index in the game's stat log
+    struct Resolved {
+        Baseball::tag_key key;
+        Baseball::Player::Record* record;
+        unsigned int logIndex;
+    };
+
+    // returns the log index of p, kept with p if it was resolved by player
+    unsigned int logIndex(const Baseball::Player::Record* p);
+
+    // returns the log index of the visiting or home team/year of the game
+    unsigned int teamIndex(bool visiting);
+
+    std::vector<Resolved> m_resolved;
+
+    // log indices of the visiting and home team/years, NO_INDEX until the
+    // first change for that team
+    unsigned int m_teams[2];
+
+    static const unsigned int NO_INDEX = ~0u;
+};
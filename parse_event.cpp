@@ -0,0 +1,427 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "parse_event.h"
+
+namespace {
+
+    // characters outside of latin-1 never match anything in the event
+    // grammar, so they are folded to 0
+    inline char charAt(const char* sz, int i) { return sz[i]; }
+    inline char charAt(const unsigned short* sz, int i) {
+        return ((sz[i] < 0x80) ? static_cast<char>(sz[i]) : 0);
+    }
+
+    inline bool isPos(char c) { return ((c >= '1') && (c <= '9')); }
+
+    template<typename C>
+    inline bool startsWith(const C* sz, int len, const char* prefix)
+    {
+        int i = 0;
+
+        for (; prefix[i]; i++) {
+            if ((i >= len) || (charAt(sz, i) != prefix[i])) return false;
+        }
+
+        return true;
+    }
+
+    // ([1-9]{0,8}[1-9](\([123B]\))?){1,3}
+    //
+    // The out expression is run as a small NFA whose states are packed into
+    // a bit set: for each of the three repetitions there are nine states for
+    // the number of fielders read, and three for the "(", base and ")" of the
+    // optional base.  The longest accepted prefix is returned.
+    template<typename C>
+    int matchOut(const C* sz, int len)
+    {
+        static const int GROUP_BITS = 12;
+        static const int OPEN = 9;
+        static const int BASE = 10;
+        static const int CLOSE = 11;
+
+        unsigned long long cur = 0;
+        bool start = true;
+        int best = 0;
+
+        for (int i = 0; i < len; i++) {
+            char c = charAt(sz, i);
+            unsigned long long next = 0;
+
+            for (int g = 0; g < 3; g++) {
+                unsigned long long grp = (cur >> (g * GROUP_BITS));
+                unsigned long long digits = (grp & 0x1ff);
+                bool done = ((digits != 0) || (grp & (1ULL << CLOSE)));
+                unsigned long long n = 0;
+
+                if (isPos(c)) {
+                    // another fielder in this repetition
+                    n |= ((digits << 1) & 0x1ff);
+
+                    // or the first fielder of the next repetition
+                    if ((done) && (g < 2)) {
+                        next |= (1ULL << ((g + 1) * GROUP_BITS));
+                    }
+                } else if (c == '(') {
+                    if (digits) n |= (1ULL << OPEN);
+                } else if (c == ')') {
+                    if (grp & (1ULL << BASE)) n |= (1ULL << CLOSE);
+                }
+
+                if ((c == '1') || (c == '2') || (c == '3') || (c == 'B')) {
+                    if (grp & (1ULL << OPEN)) n |= (1ULL << BASE);
+                }
+
+                next |= (n << (g * GROUP_BITS));
+            }
+
+            if ((start) && (isPos(c))) {
+                next |= 1ULL;
+            }
+
+            start = false;
+            cur = next;
+
+            if (!cur) break;
+
+            for (int g = 0; g < 3; g++) {
+                unsigned long long grp = (cur >> (g * GROUP_BITS));
+
+                if ((grp & 0x1ff) || (grp & (1ULL << CLOSE))) {
+                    best = i + 1;
+                }
+            }
+        }
+
+        return best;
+    }
+
+    // DGR([1-9])?|([SDT][1-9?]*)|H[^P]R?(\([1-9]\))?
+    template<typename C>
+    int matchHit(const C* sz, int len)
+    {
+        char c = charAt(sz, 0);
+        int best = 0;
+
+        if ((c == 'S') || (c == 'D') || (c == 'T')) {
+            int n = 1;
+
+            while ((n < len) &&
+                   ((isPos(charAt(sz, n))) || (charAt(sz, n) == '?'))) {
+                n++;
+            }
+
+            best = n;
+        }
+
+        if (startsWith(sz, len, "DGR")) {
+            int n = 3;
+
+            if ((n < len) && (isPos(charAt(sz, n)))) n++;
+            if (n > best) best = n;
+        }
+
+        if ((c == 'H') && (len >= 2) && (charAt(sz, 1) != 'P')) {
+            int n = 2;
+
+            if ((n < len) && (charAt(sz, n) == 'R')) n++;
+
+            if (((n + 2) < len) &&
+                (charAt(sz, n) == '(') &&
+                (isPos(charAt(sz, n + 1))) &&
+                (charAt(sz, n + 2) == ')')) {
+                n += 3;
+            }
+
+            if (n > best) best = n;
+        }
+
+        return best;
+    }
+
+    // \([1-9]{0,8}((E[1-9](/TH)?)|[1-9])\) starting at pos, returns the
+    // position following the match or 0 if there is no match
+    template<typename C>
+    int matchFielders(const C* sz, int len, int pos)
+    {
+        int i = pos + 1;
+        int n = 0;
+
+        if ((pos >= len) || (charAt(sz, pos) != '(')) return 0;
+
+        while ((i < len) && (isPos(charAt(sz, i)))) {
+            i++;
+            n++;
+        }
+
+        if (i >= len) return 0;
+
+        if (charAt(sz, i) == ')') {
+            return (((n >= 1) && (n <= 9)) ? (i + 1) : 0);
+        }
+
+        if ((charAt(sz, i) == 'E') && (n <= 8) &&
+            ((i + 1) < len) && (isPos(charAt(sz, i + 1)))) {
+            i += 2;
+
+            if (startsWith(sz + i, len - i, "/TH)")) {
+                return (i + 4);
+            } else if ((i < len) && (charAt(sz, i) == ')')) {
+                return (i + 1);
+            }
+        }
+
+        return 0;
+    }
+
+    template<typename C>
+    EventMatcher::Result matchEvent(const C* sz, int len)
+    {
+        EventMatcher::Result r = { EventMatcher::NoMatch, 0 };
+
+        if (len <= 0) return r;
+
+        char c = charAt(sz, 0);
+
+        switch (c) {
+        case '1': case '2': case '3':
+        case '4': case '5': case '6':
+        case '7': case '8': case '9':
+            r.type = EventMatcher::Out;
+            r.length = matchOut(sz, len);
+            break;
+        case 'S': case 'D': case 'T':
+            r.type = EventMatcher::Hit;
+            r.length = matchHit(sz, len);
+            break;
+        case 'H':
+            if ((len >= 2) && (charAt(sz, 1) != 'P')) {
+                r.type = EventMatcher::Hit;
+                r.length = matchHit(sz, len);
+            } else if (len >= 2) {
+                r.type = EventMatcher::Batter;
+                r.length = 2;
+            }
+            break;
+        case 'F':
+            if (startsWith(sz, len, "FC")) {
+                r.type = EventMatcher::FieldersChoice;
+                r.length = 2;
+
+                if ((len > 2) &&
+                    ((isPos(charAt(sz, 2))) || (charAt(sz, 2) == '?'))) {
+                    r.length = 3;
+                }
+            } else if ((startsWith(sz, len, "FLE")) &&
+                       (len > 3) && (isPos(charAt(sz, 3)))) {
+                r.type = EventMatcher::Error;
+                r.length = 4;
+            }
+            break;
+        case 'E':
+            if ((len > 1) && (isPos(charAt(sz, 1)))) {
+                r.type = EventMatcher::Error;
+                r.length = 2;
+            }
+            break;
+        case 'C':
+            r.type = EventMatcher::Batter;
+            r.length = 1;
+            break;
+        case 'K':
+            r.type = EventMatcher::Strikeout;
+            r.length = len;
+            break;
+        case 'I':
+        case 'W':
+            r.type = EventMatcher::Walk;
+            r.length = len;
+            break;
+        case 'N':
+            if (startsWith(sz, len, "NP")) {
+                r.type = EventMatcher::NoPlay;
+                r.length = 2;
+            }
+            break;
+        case 'B':
+            if (startsWith(sz, len, "BK")) {
+                r.type = EventMatcher::BaseRunning;
+                r.length = 2;
+            }
+            break;
+        case 'O':
+            if (startsWith(sz, len, "OA")) {
+                r.type = EventMatcher::BaseRunning;
+                r.length = 2;
+            }
+            break;
+        case 'P':
+            if (startsWith(sz, len, "PB")) {
+                r.type = EventMatcher::BaseRunning;
+                r.length = 2;
+            } else if ((startsWith(sz, len, "PO")) && (len > 2)) {
+                char b = charAt(sz, 2);
+                int end = 0;
+
+                if ((b == '1') || (b == '2') || (b == '3')) {
+                    if ((end = matchFielders(sz, len, 3)) != 0) {
+                        r.type = EventMatcher::Pickoff;
+                        r.length = end;
+                    }
+                } else if ((startsWith(sz, len, "POCS")) && (len > 4)) {
+                    b = charAt(sz, 4);
+
+                    if ((b == '1') || (b == '2') || (b == '3') || (b == 'H')) {
+                        if ((end = matchFielders(sz, len, 5)) != 0) {
+                            r.type = EventMatcher::PickoffCaughtStealing;
+                            r.length = end;
+                        }
+                    }
+                }
+            }
+            break;
+        default:
+            break;
+        }
+
+        if (r.length == 0) {
+            r.type = EventMatcher::NoMatch;
+        }
+
+        return r;
+    }
+}
+
+
+EventMatcher::Result EventMatcher::match(const char* sz, int len)
+{
+    return matchEvent(sz, len);
+}
+
+
+EventMatcher::Result EventMatcher::match(const unsigned short* sz, int len)
+{
+    return matchEvent(sz, len);
+}
+
+
+int EventMatcher::findAdvance(const unsigned short* sz, int len, int from, int& length)
+{
+    for (int i = from; (i + 3) <= len; i++) {
+        char b = charAt(sz, i);
+        char m = charAt(sz, i + 1);
+        char t = charAt(sz, i + 2);
+
+        if (((b == 'B') || (b == '1') || (b == '2') || (b == '3')) &&
+            ((m == '-') || (m == 'X')) &&
+            ((t == '1') || (t == '2') || (t == '3') || (t == 'H'))) {
+            length = 3;
+            return i;
+        }
+    }
+
+    length = 0;
+    return -1;
+}
+
+
+int EventMatcher::findOut(const unsigned short* sz, int len, int from, int& length)
+{
+    for (int i = from; i < len; i++) {
+        if (!isPos(charAt(sz, i))) continue;
+
+        // at most nine fielders, any more start the next out
+        int n = i;
+
+        while ((n < len) && ((n - i) < 9) && (isPos(charAt(sz, n)))) {
+            n++;
+        }
+
+        if (((n + 2) < len) &&
+            (charAt(sz, n) == '(') &&
+            ((charAt(sz, n + 1) == 'B') ||
+             ((charAt(sz, n + 1) >= '1') && (charAt(sz, n + 1) <= '3'))) &&
+            (charAt(sz, n + 2) == ')')) {
+            n += 3;
+        }
+
+        length = (n - i);
+        return i;
+    }
+
+    length = 0;
+    return -1;
+}
+
+
+int EventMatcher::findFielders(const unsigned short* sz, int len, int from, int& length)
+{
+    for (int i = from; i < len; i++) {
+        char c = charAt(sz, i);
+
+        if ((!isPos(c)) &&
+            ((c != 'E') || ((i + 1) >= len) || (!isPos(charAt(sz, i + 1))))) {
+            continue;
+        }
+
+        int n = i;
+
+        while ((n < len) && (isPos(charAt(sz, n)))) {
+            n++;
+        }
+
+        // an error may follow up to eight assists
+        if (((n - i) <= 8) &&
+            ((n + 1) < len) &&
+            (charAt(sz, n) == 'E') &&
+            (isPos(charAt(sz, n + 1)))) {
+            n += 2;
+
+            if (startsWith(sz + n, len - n, "/TH")) {
+                n += 3;
+
+                if ((n < len) && (isPos(charAt(sz, n)))) n++;
+            }
+        } else if ((n - i) > 9) {
+            n = (i + 9);
+        }
+
+        length = (n - i);
+        return i;
+    }
+
+    length = 0;
+    return -1;
+}
+
+
+const char* EventMatcher::name(const Class& c)
+{
+    static const char* names[NUM_CLASSES] = {
+        "none", "out", "hit", "fielder's choice", "error", "batter",
+        "strikeout", "walk", "no play", "caught stealing", "base running",
+        "pickoff", "pickoff caught stealing", "stolen base"
+    };
+
+    if ((c >= NoMatch) && (c < NUM_CLASSES)) {
+        return names[c];
+    }
+
+    return "?";
+}
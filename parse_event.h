@@ -0,0 +1,83 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+// The EventMatcher classifies the event field of a play (the portion of the
+// field before any modifiers or advances is what determines the class) in a
+// single pass over its characters, without any regular expressions.
+//
+// It reproduces the event regex table in Parser::initEvents exactly: each
+// class below corresponds to a row of that table, in order, and the matched
+// length is the length of the longest match of that row at the start of the
+// string.  Because the table is tried in order, a few rows can never match:
+// every 'C' event is taken by the interference row ("C"), every 'S' event by
+// the hit row ("S"), "DI" by the hit row ("D") and "WP" by the walk row.  The
+// matcher keeps that behavior so that both produce the same results.
+class EventMatcher
+{
+public:
+    enum Class
+    {
+        NoMatch = 0,
+        Out,                    // ([1-9]{0,8}[1-9](\([123B]\))?){1,3}
+        Hit,                    // DGR([1-9])?|([SDT][1-9?]*)|H[^P]R?(\([1-9]\))?
+        FieldersChoice,         // FC([1-9?])?
+        Error,                  // [1-9]{0,8}E[1-9]|FLE[1-9]
+        Batter,                 // HP|C
+        Strikeout,              // ^K(.*)?
+        Walk,                   // ^(IW?|W)(.*)?
+        NoPlay,                 // NP
+        CaughtStealing,         // CS[23H]... (never reached, see above)
+        BaseRunning,            // BK|DI|OA|PB|WP
+        Pickoff,                // PO[123]\(...\)
+        PickoffCaughtStealing,  // POCS[123H]\(...\)
+        StolenBase,             // SB[23H]... (never reached, see above)
+
+        NUM_CLASSES
+    };
+
+    struct Result
+    {
+        Class type;
+
+        // length of the match at the start of the string, 0 if type
+        // is NoMatch
+        int length;
+    };
+
+    static Result match(const char* sz, int len);
+    static Result match(const unsigned short* sz, int len);
+
+    // returns the row name of the given class, for diagnostics
+    static const char* name(const Class& c);
+
+    // The play handlers search parts of an event with these rather than
+    // with regular expressions.  Each returns the position of the leftmost
+    // longest match at or after from, or -1, and sets length.
+
+    // [B123][-X][123H], the base advanced from and to
+    static int findAdvance(const unsigned short* sz, int len, int from, int& length);
+
+    // [1-9]{0,8}[1-9](\([123B]\))?, a single out
+    static int findOut(const unsigned short* sz, int len, int from, int& length);
+
+    // [1-9]{0,8}((E[1-9](/TH[1-9]?)?)|[1-9]), the fielders of a play
+    static int findFielders(const unsigned short* sz, int len, int from, int& length);
+};
@@ -0,0 +1,83 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "parse_loader.h"
+#include "parse_reader.h"
+#include "parse_worker.h"
+
+#include <QFile>
+
+#include <algorithm>
+#include <vector>
+
+GameLoader::GameLoader(const QString& dbPath, Sabre::Output* out) :
+    m_dbPath(dbPath),
+    m_parser(dbPath, out)
+{
+
+}
+
+
+bool GameLoader::load(Baseball::Game::Record* r)
+{
+    if ((!r) || (!r->source.isValid())) {
+        return false;
+    }
+
+    QFile f(m_dbPath.absoluteFilePath(r->source.fileName));
+
+    if ((!f.open(QIODevice::ReadOnly)) || (!f.seek(r->source.offset))) {
+        return false;
+    }
+
+    QByteArray buffer = f.read(r->source.length);
+
+    if (buffer.size() != r->source.length) {
+        return false;
+    }
+
+    std::vector<FieldList> records;
+    ParseBatch batch;
+
+    FieldList::splitLines(buffer.constData(), buffer.size(), records);
+
+    ParseContext ctx(f.fileName(), &batch);
+
+    m_parser.parseRecords(ctx, r->year, records);
+
+    Baseball::Game::Record* g = batch.game(r->id());
+
+    if (!g) {
+        return false;
+    }
+
+    // the stub keeps its place in the file and the statistics logged when
+    // it was indexed, which have already been applied to its players.
+    // Everything else comes from the parsed game.
+    Baseball::Game::Source source = r->source;
+
+    std::swap(g->stats, r->stats);
+
+    *r = *g;
+    r->source = source;
+
+    batch.commitStates();
+
+    return true;
+}
@@ -0,0 +1,47 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QString>
+#include <QDir>
+
+#include "sabre_output.h"
+#include "parse.h"
+
+#include "baseball.h"
+
+// Loads the plays of a game stub from its event file, for the games created
+// by a parser with lazy games set.  Only the byte range of the game is read
+// and parsed.  The game and its plays are filled in, the statistics of its
+// players were applied when it was indexed and are not changed.
+class GameLoader : public Baseball::Game::Loader
+{
+public:
+    GameLoader(const QString& dbPath, Sabre::Output* out);
+
+    bool load(Baseball::Game::Record* r);
+
+private:
+
+    QDir m_dbPath;
+
+    // parse context reused for every game
+    Parser m_parser;
+};
@@ -0,0 +1,229 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "parse_pipeline.h"
+#include "parse_worker.h"
+#include "parse.h"
+
+#include <QThreadPool>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace {
+
+    // maps every file into its job and reads it into memory, so that the
+    // disk is read while the later stages work on earlier files
+    class ReadStage : public QRunnable
+    {
+    public:
+        ReadStage(const QStringList& files, int year, BoundedQueue<ParseJob*>& out) :
+            m_files(files), m_year(year), m_out(out) {}
+
+        void run()
+        {
+            for (int i = 0; i < m_files.size(); i++) {
+                ParseJob* job = new ParseJob(i, m_files.at(i), m_year);
+                QElapsedTimer t;
+
+                t.start();
+
+                if (job->file.open()) {
+                    job->size = job->file.prefault();
+                    job->opened = true;
+                }
+
+                stats.add(1, job->size, t.nsecsElapsed());
+
+                m_out.push(job);
+            }
+
+            m_out.close();
+        }
+
+        StageStats stats;
+
+    private:
+        QStringList m_files;
+        int m_year;
+        BoundedQueue<ParseJob*>& m_out;
+    };
+
+
+    // splits each buffer into records
+    class TokenizeStage : public QRunnable
+    {
+    public:
+        TokenizeStage(BoundedQueue<ParseJob*>& in, BoundedQueue<ParseJob*>& out) :
+            m_in(in), m_out(out) {}
+
+        void run()
+        {
+            ParseJob* job = NULL;
+
+            while (m_in.pop(job)) {
+                QElapsedTimer t;
+
+                t.start();
+
+                FieldList::splitLines(job->file.data(), job->file.size(), job->records);
+
+                stats.add(job->records.size(), job->size, t.nsecsElapsed());
+
+                m_out.push(job);
+            }
+
+            m_out.close();
+        }
+
+        StageStats stats;
+
+    private:
+        BoundedQueue<ParseJob*>& m_in;
+        BoundedQueue<ParseJob*>& m_out;
+    };
+
+    void logStage(Sabre::Output* out, const char* name, const char* unit, const StageStats& s)
+    {
+        double ms = s.nsecs / 1000000.0;
+        double secs = s.nsecs / 1000000000.0;
+        double mb = s.bytes / (1024.0 * 1024.0);
+
+        out->log("  %-8s %10llu %-7s %8.1f MB %10.1f ms busy %12.0f %s/s %8.1f MB/s",
+                 name, s.items, unit, mb, ms,
+                 ((secs > 0) ? (s.items / secs) : 0.0), unit,
+                 ((secs > 0) ? (mb / secs) : 0.0));
+    }
+}
+
+
+ParsePipeline::ParsePipeline(Parser* parser, int workers) :
+    m_parser(parser),
+    m_workers(std::max(1, workers)),
+    m_nsecs(0)
+{
+
+}
+
+
+bool ParsePipeline::run(const QStringList& files, int year)
+{
+    bool ret = true;
+    QElapsedTimer total;
+    QThreadPool pool;
+
+    BoundedQueue<ParseJob*> read(QUEUE_DEPTH);
+    BoundedQueue<ParseJob*> tokenized(QUEUE_DEPTH);
+    BoundedQueue<ParseJob*> parsed(QUEUE_DEPTH, m_workers);
+
+    ReadStage reader(files, year, read);
+    TokenizeStage tokenizer(read, tokenized);
+    std::vector<ParseWorker*> workers;
+
+    total.start();
+
+    reader.setAutoDelete(false);
+    tokenizer.setAutoDelete(false);
+
+    pool.setMaxThreadCount(m_workers + 2);
+
+    pool.start(&reader);
+    pool.start(&tokenizer);
+
+    for (int i = 0; i < m_workers; i++) {
+        ParseWorker* w = new ParseWorker(m_parser->m_dbPath.absolutePath(),
+                                         m_parser->m_output,
+                                         tokenized, parsed,
+                                         m_parser->m_verifyEvents);
+
+        w->setAutoDelete(false);
+        workers.push_back(w);
+
+        pool.start(w);
+    }
+
+    // batches finish out of order, they are held here until every file
+    // before them has been committed
+    std::map<int, ParseJob*> pending;
+    ParseJob* job = NULL;
+    int next = 0;
+
+    while (parsed.pop(job)) {
+        pending[job->index] = job;
+
+        std::map<int, ParseJob*>::iterator it = pending.find(next);
+
+        while (it != pending.end()) {
+            QElapsedTimer t;
+
+            job = it->second;
+
+            t.start();
+
+            m_parser->m_output->raw(".");
+
+            // a file which could not be read is left out of the manifest, so
+            // that a refresh tries it again
+            if (!job->opened) {
+                qWarning("Error: could not open %s", job->fileName.toStdString().c_str());
+                ret = false;
+            } else {
+                m_parser->m_eventMismatches += job->mismatches;
+
+                size_t games = Baseball::Game::Table::count();
+
+                m_parser->commitBatch(job->fileName, job->batch, job->hash);
+
+                m_stats[Commit].add(Baseball::Game::Table::count() - games, job->size, t.nsecsElapsed());
+            }
+
+            delete job;
+
+            pending.erase(it);
+            it = pending.find(++next);
+        }
+    }
+
+    pool.waitForDone();
+
+    m_stats[Read] += reader.stats;
+    m_stats[Tokenize] += tokenizer.stats;
+
+    for (unsigned int i = 0; i < workers.size(); i++) {
+        m_stats[Parse] += workers[i]->stats();
+        delete workers[i];
+    }
+
+    m_nsecs += total.nsecsElapsed();
+
+    return ret;
+}
+
+
+void ParsePipeline::report(Sabre::Output* out) const
+{
+    out->log("Parse pipeline, %d worker(s), %.1f ms:", m_workers, m_nsecs / 1000000.0);
+
+    logStage(out, "read", "files", m_stats[Read]);
+    logStage(out, "tokenize", "lines", m_stats[Tokenize]);
+    logStage(out, "parse", "lines", m_stats[Parse]);
+    logStage(out, "commit", "games", m_stats[Commit]);
+}
@@ -0,0 +1,73 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QString>
+#include <QStringList>
+
+#include "sabre_output.h"
+#include "parse_stage.h"
+
+class Parser;
+
+// Parses event files in four stages, each on its own thread(s), connected
+// by bounded queues:
+//
+//   read      reads each file into a buffer
+//   tokenize  splits a buffer into lines and fields
+//   parse     parses the records of a file into a batch (several workers)
+//   commit    commits the batches to the tables, in file order
+//
+// so that reading from disk overlaps with parsing.  The commit stage runs
+// on the thread calling run, which owns the tables.  The work and busy time
+// of every stage is kept across runs for report.
+class ParsePipeline
+{
+public:
+    enum Stage {
+        Read = 0,
+        Tokenize,
+        Parse,
+        Commit,
+        NUM_STAGES
+    };
+
+    // number of files allowed to wait between two stages
+    static const unsigned int QUEUE_DEPTH = 4;
+
+    ParsePipeline(Parser* parser, int workers);
+
+    // parses files of the given year, returns false if a file could not be
+    // read
+    bool run(const QStringList& files, int year);
+
+    const StageStats& stats(const Stage& s) const { return m_stats[s]; }
+
+    // logs the throughput of every stage
+    void report(Sabre::Output* out) const;
+
+private:
+
+    Parser* m_parser;
+    int m_workers;
+
+    StageStats m_stats[NUM_STAGES];
+    qint64 m_nsecs;
+};
@@ -0,0 +1,381 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "parse_reader.h"
+#include "parse_scan.h"
+
+#include <QCryptographicHash>
+
+#include <algorithm>
+#include <string.h>
+
+#if defined(Q_OS_UNIX)
+#   include <sys/mman.h>
+#endif
+
+FieldRef FieldRef::mid(int pos, int len) const
+{
+    if ((pos < 0) || (pos >= m_length)) {
+        return FieldRef();
+    }
+
+    if ((len < 0) || (len > (m_length - pos))) {
+        len = m_length - pos;
+    }
+
+    return FieldRef(m_data + pos, len);
+}
+
+
+bool FieldRef::operator==(const char* sz) const
+{
+    int len = strlen(sz);
+
+    return ((len == m_length) &&
+            (memcmp(m_data, sz, len) == 0));
+}
+
+
+int FieldRef::toInt(bool* ok) const
+{
+    int i = 0;
+    bool neg = false;
+
+    if ((m_length > 0) &&
+        ((m_data[0] == '-') || (m_data[0] == '+'))) {
+        neg = (m_data[0] == '-');
+        i++;
+    }
+
+    unsigned int v = FieldRef(m_data + i, m_length - i).toUInt(ok);
+
+    return (neg ? -static_cast<int>(v) : static_cast<int>(v));
+}
+
+
+unsigned int FieldRef::toUInt(bool* ok) const
+{
+    unsigned int v = 0;
+    bool valid = (m_length > 0);
+
+    for (int i = 0; (valid) && (i < m_length); i++) {
+        char c = m_data[i];
+
+        if ((c >= '0') && (c <= '9')) {
+            v = (v * 10) + (c - '0');
+        } else {
+            valid = false;
+        }
+    }
+
+    if (ok) {
+        *ok = valid;
+    }
+
+    return (valid ? v : 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+void FieldList::split(const FieldRef& line)
+{
+    const char* p = line.data();
+    const char* end = p + line.length();
+
+    // most lines have no quotes at all, and are split with memchr alone
+    bool quoted = (memchr(p, '"', end - p) != NULL);
+
+    m_line = line;
+    m_count = 0;
+    m_quoted = 0;
+
+    while (m_count < (MAX_FIELDS - 1)) {
+        const char* c = nextComma(p, end, quoted);
+
+        if (!c) break;
+
+        addField(p, c);
+        p = c + 1;
+    }
+
+    // a remainder holding more than one field is kept as it is
+    if ((quoted) && (nextComma(p, end, quoted))) {
+        m_fields[m_count++] = FieldRef(p, end - p);
+    } else {
+        addField(p, end);
+    }
+}
+
+
+void FieldList::split(const FieldRef& line, const char* base, const quint32* commas, int count)
+{
+    const char* p = line.data();
+    const char* end = p + line.length();
+
+    m_line = line;
+    m_count = 0;
+    m_quoted = 0;
+
+    for (int i = 0; (i < count) && (m_count < (MAX_FIELDS - 1)); i++) {
+        const char* c = base + commas[i];
+
+        m_fields[m_count++] = FieldRef(p, c - p);
+        p = c + 1;
+    }
+
+    m_fields[m_count++] = FieldRef(p, end - p);
+}
+
+
+const char* FieldList::nextComma(const char* p, const char* end, bool quoted)
+{
+    if (!quoted) {
+        return static_cast<const char*>(memchr(p, ',', end - p));
+    }
+
+    bool inQuotes = false;
+
+    for (; p < end; p++) {
+        if (*p == '"') {
+            inQuotes = !inQuotes;
+        } else if ((*p == ',') && (!inQuotes)) {
+            return p;
+        }
+    }
+
+    // an unclosed quote runs to the end of the line
+    return NULL;
+}
+
+
+void FieldList::addField(const char* p, const char* end)
+{
+    if (((end - p) >= 2) && (p[0] == '"') && (end[-1] == '"')) {
+        m_quoted |= (1u << m_count);
+        m_fields[m_count++] = FieldRef(p + 1, (end - p) - 2);
+    } else {
+        m_fields[m_count++] = FieldRef(p, end - p);
+    }
+}
+
+
+FieldRef FieldList::rest(int i) const
+{
+    if ((i < 0) || (i >= m_count)) {
+        return FieldRef();
+    }
+
+    // the rest of the line starts at the opening quote of a quoted field
+    const char* p = m_fields[i].data() - ((m_quoted >> i) & 1);
+
+    return FieldRef(p, (m_line.data() + m_line.length()) - p);
+}
+
+
+void FieldList::splitLines(const char* data, qint64 size, std::vector<FieldList>& records)
+{
+    std::vector<quint32> offsets;
+
+    DelimiterScan::scan(data, size, offsets);
+
+    // event files average about 40 characters a line
+    records.reserve(records.size() + static_cast<size_t>(size / 32) + 1);
+
+    const quint32* d = offsets.empty() ? NULL : &offsets[0];
+    const quint32* dend = d + offsets.size();
+    qint64 pos = 0;
+
+    while (pos < size) {
+        const quint32* first = d;
+        qint64 eol = size;
+        bool quoted = false;
+
+        // the commas of this line run up to its line break
+        for (; d < dend; d++) {
+            char c = data[*d];
+
+            if (c == '\n') {
+                eol = *d;
+                break;
+            } else if (c == '"') {
+                quoted = true;
+            }
+        }
+
+        int commas = static_cast<int>(d - first);
+        qint64 next = ((d < dend) ? (eol + 1) : size);
+        const char* start = data + pos;
+        const char* stop = data + eol;
+
+        // strip the carriage return of dos line endings
+        while ((stop > start) && (stop[-1] == '\r')) {
+            stop--;
+        }
+
+        records.push_back(FieldList());
+
+        // quoted lines are rare and go the long way round
+        if (quoted) {
+            records.back().split(FieldRef(start, stop - start));
+        } else {
+            records.back().split(FieldRef(start, stop - start), data, first, commas);
+        }
+
+        if (d < dend) d++;
+        pos = next;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+FileReader::FileReader(const QString& fileName) :
+    m_file(fileName),
+    m_map(NULL),
+    m_data(NULL),
+    m_size(0),
+    m_pos(0)
+{
+
+}
+
+
+FileReader::~FileReader()
+{
+    close();
+}
+
+
+bool FileReader::open()
+{
+    close();
+
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    m_size = m_file.size();
+
+    if (m_size > 0) {
+        m_map = m_file.map(0, m_size);
+    }
+
+    if (m_map) {
+        m_data = reinterpret_cast<const char*>(m_map);
+    } else {
+        m_buffer = m_file.readAll();
+        m_data = m_buffer.constData();
+        m_size = m_buffer.size();
+    }
+
+    return true;
+}
+
+
+qint64 FileReader::prefault()
+{
+    static const qint64 PAGE_SIZE = 4096;
+
+    // a file read into m_buffer is already in memory
+    if (!m_map) {
+        return m_size;
+    }
+
+#if defined(Q_OS_UNIX)
+    // let the kernel read ahead over the whole file, the walk below then
+    // mostly waits on reads already under way
+    madvise(m_map, m_size, MADV_WILLNEED);
+#endif
+
+    volatile unsigned char sink = 0;
+
+    for (qint64 i = 0; i < m_size; i += PAGE_SIZE) {
+        sink ^= m_map[i];
+    }
+
+    sink ^= m_map[m_size - 1];
+
+    return m_size;
+}
+
+
+QByteArray FileReader::hash() const
+{
+    QCryptographicHash h(QCryptographicHash::Sha1);
+    qint64 done = 0;
+
+    // addData takes an int length
+    while (done < m_size) {
+        int n = static_cast<int>(std::min<qint64>(m_size - done, 0x40000000));
+
+        h.addData(m_data + done, n);
+        done += n;
+    }
+
+    return h.result();
+}
+
+
+void FileReader::close()
+{
+    if (m_map) {
+        m_file.unmap(m_map);
+        m_map = NULL;
+    }
+
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+
+    m_buffer.clear();
+    m_data = NULL;
+    m_size = 0;
+    m_pos = 0;
+}
+
+
+FieldRef FileReader::readLine()
+{
+    if (atEnd()) {
+        return FieldRef();
+    }
+
+    return nextLine(m_data, m_size, m_pos);
+}
+
+
+FieldRef FileReader::nextLine(const char* data, qint64 size, qint64& pos)
+{
+    const char* start = data + pos;
+    const char* end = data + size;
+    const char* nl = static_cast<const char*>(memchr(start, '\n', end - start));
+    const char* eol = (nl ? nl : end);
+
+    pos = ((nl ? (nl + 1) : end) - data);
+
+    // strip the carriage return of dos line endings
+    while ((eol > start) && (eol[-1] == '\r')) {
+        eol--;
+    }
+
+    return FieldRef(start, eol - start);
+}
@@ -0,0 +1,160 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QByteArray>
+
+#include <string>
+#include <vector>
+
+// A FieldRef refers to a run of characters inside a file buffer, typically a
+// line or a single field of a line.  It does not own its characters and is
+// only valid as long as the FileReader it came from is open.
+class FieldRef
+{
+public:
+    FieldRef() : m_data(NULL), m_length(0) {}
+    FieldRef(const char* d, int len) : m_data(d), m_length(len) {}
+
+    const char* data() const { return m_data; }
+    int length() const { return m_length; }
+    bool isEmpty() const { return (m_length == 0); }
+
+    // returns the character at i, or 0 if i is out of range
+    char at(int i) const {
+        return (((i >= 0) && (i < m_length)) ? m_data[i] : 0);
+    }
+
+    FieldRef mid(int pos, int len = -1) const;
+
+    bool operator==(const char* sz) const;
+    bool operator!=(const char* sz) const { return (false == operator==(sz)); }
+
+    int toInt(bool* ok = NULL) const;
+    unsigned int toUInt(bool* ok = NULL) const;
+
+    std::string toStdString() const { return std::string(m_data, m_length); }
+    QString toString() const { return QString::fromLatin1(m_data, m_length); }
+
+private:
+    const char* m_data;
+    int m_length;
+};
+
+
+// Splits a line at each comma.  Fields refer to the line itself, so
+// splitting never allocates.  Commas inside double quotes do not split, and
+// the quotes around a quoted field are not part of the field.  A line with
+// more than MAX_FIELDS fields keeps the remainder of the line, as is, in the
+// last field.
+class FieldList
+{
+public:
+    static const int MAX_FIELDS = 16;
+
+    FieldList() : m_count(0), m_quoted(0) {}
+
+    void split(const FieldRef& line);
+
+    // splits a line without quotes at the given commas, which are offsets
+    // into the buffer starting at base
+    void split(const FieldRef& line, const char* base, const quint32* commas, int count);
+
+    int size() const { return m_count; }
+
+    // returns field i, or an empty field if i is out of range
+    FieldRef at(int i) const {
+        return (((i >= 0) && (i < m_count)) ? m_fields[i] : FieldRef());
+    }
+
+    // returns everything from the start of field i to the end of the line
+    FieldRef rest(int i) const;
+
+    // splits every line of data into its own record.  The records refer
+    // into data.  The delimiters of the whole buffer are found up front by
+    // a DelimiterScan.
+    static void splitLines(const char* data, qint64 size, std::vector<FieldList>& records);
+
+private:
+    // returns the first comma at or after p which is not inside quotes
+    static const char* nextComma(const char* p, const char* end, bool quoted);
+
+    // adds the field from p up to end, without its quotes
+    void addField(const char* p, const char* end);
+
+    FieldRef m_line;
+    FieldRef m_fields[MAX_FIELDS];
+    int m_count;
+
+    // bit i is set if the quotes were taken off field i
+    unsigned int m_quoted;
+};
+
+
+// Reads a file by mapping it read only into memory and handing out each line
+// in place.  If the file cannot be mapped it is read into a single buffer.
+class FileReader
+{
+public:
+    FileReader(const QString& fileName);
+    ~FileReader();
+
+    bool open();
+    void close();
+
+    // brings a mapped file into memory by touching each of its pages, so
+    // that the disk is read here and not where the data is first used.
+    // Returns the number of bytes made resident.
+    qint64 prefault();
+
+    bool atEnd() const { return (m_pos >= m_size); }
+
+    // offset of the next line in the file
+    qint64 pos() const { return m_pos; }
+
+    // returns the next line with its line terminator removed
+    FieldRef readLine();
+
+    // returns the line of data starting at pos with its line terminator
+    // removed, and moves pos to the start of the next line
+    static FieldRef nextLine(const char* data, qint64 size, qint64& pos);
+
+    QString fileName() const { return m_file.fileName(); }
+
+    // the whole file, valid until the reader is closed
+    const char* data() const { return m_data; }
+    qint64 size() const { return m_size; }
+
+    // the SHA-1 digest of the whole file, as recorded in the manifest
+    QByteArray hash() const;
+
+private:
+    QFile m_file;
+
+    // mapped view of the file, NULL if the file was read into m_buffer
+    uchar* m_map;
+    QByteArray m_buffer;
+
+    const char* m_data;
+    qint64 m_size;
+    qint64 m_pos;
+};
@@ -0,0 +1,124 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "parse_scan.h"
+
+#if defined(__AVX2__)
+#   include <immintrin.h>
+#   define SCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#   include <emmintrin.h>
+#   define SCAN_SSE2
+#endif
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#endif
+
+namespace {
+
+    // index of the lowest set bit of a non-zero mask
+    inline unsigned int lowestBit(quint32 mask)
+    {
+#if defined(_MSC_VER)
+        unsigned long i;
+        _BitScanForward(&i, mask);
+        return i;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    // appends base plus the index of each set bit of mask
+    inline void addMask(quint32 mask, quint32 base, std::vector<quint32>& offsets)
+    {
+        while (mask) {
+            offsets.push_back(base + lowestBit(mask));
+            mask &= (mask - 1);
+        }
+    }
+}
+
+
+void DelimiterScan::scan(const char* data, qint64 size, std::vector<quint32>& offsets)
+{
+    qint64 i = 0;
+
+    // event files average about 40 characters and 6 commas a line
+    offsets.reserve(offsets.size() + static_cast<size_t>(size / 6) + 1);
+
+#if defined(SCAN_AVX2)
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i quote = _mm256_set1_epi8('"');
+
+    for (; (i + 32) <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, nl),
+                                                    _mm256_cmpeq_epi8(v, comma)),
+                                    _mm256_cmpeq_epi8(v, quote));
+
+        addMask(static_cast<quint32>(_mm256_movemask_epi8(m)), static_cast<quint32>(i), offsets);
+    }
+#elif defined(SCAN_SSE2)
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i quote = _mm_set1_epi8('"');
+
+    for (; (i + 16) <= size; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        __m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, nl),
+                                              _mm_cmpeq_epi8(v, comma)),
+                                 _mm_cmpeq_epi8(v, quote));
+
+        addMask(static_cast<quint32>(_mm_movemask_epi8(m)), static_cast<quint32>(i), offsets);
+    }
+#endif
+
+    // whatever is left over is shorter than one vector
+    for (; i < size; i++) {
+        if (isDelimiter(data[i])) {
+            offsets.push_back(static_cast<quint32>(i));
+        }
+    }
+}
+
+
+void DelimiterScan::scanScalar(const char* data, qint64 size, std::vector<quint32>& offsets)
+{
+    offsets.reserve(offsets.size() + static_cast<size_t>(size / 6) + 1);
+
+    for (qint64 i = 0; i < size; i++) {
+        if (isDelimiter(data[i])) {
+            offsets.push_back(static_cast<quint32>(i));
+        }
+    }
+}
+
+
+const char* DelimiterScan::instructionSet()
+{
+#if defined(SCAN_AVX2)
+    return "AVX2";
+#elif defined(SCAN_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,46 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QtGlobal>
+
+#include <vector>
+
+// Finds every line break, comma and double quote of a file buffer in a
+// single pass.  The result is a list of offsets into the buffer, in order,
+// from which the lines and fields can be cut without looking at any other
+// character again.  The scan uses SSE2 or AVX2 when the build targets them
+// and a plain loop otherwise.
+class DelimiterScan
+{
+public:
+    // appends the offset of each delimiter in data to offsets
+    static void scan(const char* data, qint64 size, std::vector<quint32>& offsets);
+
+    // the same, one character at a time
+    static void scanScalar(const char* data, qint64 size, std::vector<quint32>& offsets);
+
+    // name of the instruction set used by scan
+    static const char* instructionSet();
+
+    static bool isDelimiter(char c) {
+        return ((c == '\n') || (c == ',') || (c == '"'));
+    }
+};
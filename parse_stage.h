@@ -0,0 +1,129 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+
+#include <deque>
+
+// A queue connecting two stages of the parse pipeline.  push blocks while
+// the queue is full and pop blocks while it is empty, so a fast stage can
+// only run a few items ahead of a slow one.
+//
+// A queue may have several producers.  Each calls close when it has
+// pushed its last item, and once all of them have, pop returns false as
+// soon as the queue is drained.
+template<typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(unsigned int capacity, unsigned int producers = 1) :
+        m_capacity(capacity),
+        m_producers(producers)
+    {
+
+    }
+
+    void push(const T& item)
+    {
+        QMutexLocker lock(&m_mutex);
+
+        while (m_items.size() >= m_capacity) {
+            m_notFull.wait(&m_mutex);
+        }
+
+        m_items.push_back(item);
+        m_notEmpty.wakeOne();
+    }
+
+    // takes the next item, returns false if the queue is closed and empty
+    bool pop(T& item)
+    {
+        QMutexLocker lock(&m_mutex);
+
+        while ((m_items.empty()) && (m_producers > 0)) {
+            m_notEmpty.wait(&m_mutex);
+        }
+
+        if (m_items.empty()) {
+            return false;
+        }
+
+        item = m_items.front();
+        m_items.pop_front();
+        m_notFull.wakeOne();
+
+        return true;
+    }
+
+    // called by each producer after its last push
+    void close()
+    {
+        QMutexLocker lock(&m_mutex);
+
+        if (m_producers > 0) {
+            m_producers--;
+        }
+
+        if (m_producers == 0) {
+            m_notEmpty.wakeAll();
+        }
+    }
+
+private:
+    BoundedQueue(const BoundedQueue&);
+    BoundedQueue& operator=(const BoundedQueue&);
+
+    std::deque<T> m_items;
+    size_t m_capacity;
+    unsigned int m_producers;
+
+    QMutex m_mutex;
+    QWaitCondition m_notFull;
+    QWaitCondition m_notEmpty;
+};
+
+
+// Work done by one stage of the pipeline.  Time is only counted while the
+// stage is working, not while it waits on a queue, so items / nsecs is the
+// rate the stage could sustain on its own.
+struct StageStats
+{
+    StageStats() : items(0), bytes(0), nsecs(0) {}
+
+    void add(quint64 i, quint64 b, qint64 ns)
+    {
+        items += i;
+        bytes += b;
+        nsecs += ns;
+    }
+
+    StageStats& operator+=(const StageStats& rhs)
+    {
+        add(rhs.items, rhs.bytes, rhs.nsecs);
+        return *this;
+    }
+
+    quint64 items;
+    quint64 bytes;
+    qint64 nsecs;
+};
@@ -0,0 +1,182 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "parse_worker.h"
+#include "parse.h"
+
+#include <QElapsedTimer>
+
+#include <algorithm>
+
+ParseBatch::~ParseBatch()
+{
+    for (unsigned int i = 0; i < m_games.size(); i++) {
+        delete m_games[i];
+    }
+}
+
+
+Baseball::Game::Record* ParseBatch::createGame(const Baseball::game_tag& t)
+{
+    GameMap::iterator it = m_gameMap.find(t);
+
+    if (it != m_gameMap.end()) {
+        return it->second;
+    }
+
+    Baseball::Game::Record* r = new Baseball::Game::Record(t);
+
+    m_games.push_back(r);
+    m_gameMap[t] = r;
+
+    return r;
+}
+
+
+Baseball::Player::Record* ParseBatch::player(const Baseball::player_tag& t)
+{
+    // the player table is only read here, it is not modified while game
+    // data is being parsed
+    return Baseball::Player::Table::get(t);
+}
+
+
+Baseball::StateLink ParseBatch::createState(const Baseball::State::Type& t)
+{
+    return m_states.create(t);
+}
+
+
+Baseball::Game::Record* ParseBatch::game(const Baseball::tag& t) const
+{
+    // a batch holds the games of a single file at most
+    for (unsigned int i = 0; i < m_games.size(); i++) {
+        if (m_games[i]->id() == t) {
+            return m_games[i];
+        }
+    }
+
+    return NULL;
+}
+
+
+void ParseBatch::commitStates()
+{
+    Baseball::StateManager::getInstance()->merge(m_states);
+}
+
+
+void ParseBatch::dropStates()
+{
+    for (unsigned int i = 0; i < m_games.size(); i++) {
+        m_games[i]->plays = NULL;
+    }
+
+    m_states.reset();
+}
+
+
+void ParseBatch::commit(std::vector<Baseball::Game::Record*>& unreduced,
+                        Baseball::Manifest::Entry* entry)
+{
+    Baseball::StateManager::getInstance()->merge(m_states);
+
+    for (unsigned int i = 0; i < m_games.size(); i++) {
+        Baseball::Game::Record* r = m_games[i];
+        Baseball::Game::Record* g = Baseball::Game::Table::get(r->id());
+
+        // a game id repeated across files replaces the earlier game
+        if (g) {
+            std::vector<Baseball::Game::Record*>::iterator it =
+                std::find(unreduced.begin(), unreduced.end(), g);
+
+            if (it != unreduced.end()) {
+                unreduced.erase(it);
+            } else {
+                g->stats.apply(true);
+            }
+
+            Baseball::Game::Cache::forget(g->id());
+            Baseball::StateManager::removeChain(g->plays);
+            Baseball::Manifest::releaseGame(g->id());
+
+            delete g;
+        }
+
+        r->stats.compact();
+
+        Baseball::Game::Table::store(r->id(), r);
+        unreduced.push_back(r);
+
+        if (entry) {
+            entry->games.push_back(r->id());
+        }
+    }
+
+    m_games.clear();
+    m_gameMap.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+ParseWorker::ParseWorker(const QString& dbPath,
+                         Sabre::Output* out,
+                         BoundedQueue<ParseJob*>& in,
+                         BoundedQueue<ParseJob*>& parsed,
+                         bool verifyEvents) :
+    m_dbPath(dbPath),
+    m_output(out),
+    m_in(in),
+    m_parsed(parsed),
+    m_verifyEvents(verifyEvents)
+{
+
+}
+
+
+void ParseWorker::run()
+{
+    Parser p(m_dbPath, m_output);
+    ParseJob* job = NULL;
+
+    p.setVerifyEvents(m_verifyEvents);
+
+    while (m_in.pop(job)) {
+        QElapsedTimer t;
+        ParseContext ctx(job->fileName, &job->batch);
+
+        t.start();
+
+        p.parseRecords(ctx, job->year, job->records);
+
+        job->mismatches = ctx.mismatches;
+        job->hash = job->file.hash();
+
+        m_stats.add(job->records.size(), job->size, t.nsecsElapsed());
+
+        // the records are not needed once parsed
+        std::vector<FieldList>().swap(job->records);
+
+        m_parsed.push(job);
+    }
+
+    m_parsed.close();
+}
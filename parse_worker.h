@@ -0,0 +1,157 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QRunnable>
+
+#include <map>
+#include <vector>
+
+#include "sabre_output.h"
+#include "parse_reader.h"
+#include "parse_stage.h"
+
+#include "baseball.h"
+
+// A ParseBatch holds everything produced by parsing a single event file:
+// the games, their state chains, and the statistics credited to each player.
+// Batches are filled without touching the global tables, so several can be
+// filled at once, and are then committed to the tables one at a time.
+class ParseBatch
+{
+public:
+    ParseBatch() {}
+    ~ParseBatch();
+
+    // creates a game owned by this batch, or returns the game already
+    // created for this tag
+    Baseball::Game::Record* createGame(const Baseball::game_tag& t);
+
+    // returns the record of player t, or NULL if t is not in the player
+    // table.  Statistics are logged in the games, the record is only read.
+    Baseball::Player::Record* player(const Baseball::player_tag& t);
+
+    Baseball::StateLink createState(const Baseball::State::Type& t);
+
+    // makes room for n more states, so that the states of the batch fill
+    // slabs of their own size
+    void reserveStates(unsigned int n) { m_states.reserve(n); }
+
+    // returns the game parsed for t, or NULL.  The game stays owned by the
+    // batch.
+    Baseball::Game::Record* game(const Baseball::tag& t) const;
+
+    // moves only the states of this batch into the state manager, leaving
+    // the games and statistics in the batch
+    void commitStates();
+
+    // destroys the states of this batch and unlinks them from its games,
+    // so that only the games and their statistics are committed
+    void dropStates();
+
+    // moves the games and states of this batch into the global tables.
+    // The batch is left empty.  This must not be called from more than one
+    // thread at a time.
+    //
+    // The statistics of the games are not applied, the games are added to
+    // unreduced instead so their logs can be reduced together.  A game
+    // replacing an earlier one takes the earlier game's statistics back out.
+    //
+    // When entry is set, the tags of the games are handed to it so that
+    // they can be taken back later.
+    void commit(std::vector<Baseball::Game::Record*>& unreduced,
+                Baseball::Manifest::Entry* entry = NULL);
+
+private:
+
+    typedef std::map<Baseball::game_tag, Baseball::Game::Record*> GameMap;
+
+    // games in the order they were created
+    std::vector<Baseball::Game::Record*> m_games;
+    GameMap m_gameMap;
+
+    Baseball::StateManager m_states;
+};
+
+
+// One event file as it moves through the parse pipeline.  The reader
+// fills the buffer, the tokenizer splits it into records which refer into
+// the buffer, a worker parses the records into the batch, and the batch is
+// then committed.
+struct ParseJob
+{
+    ParseJob(int i, const QString& f, int y) :
+        index(i), fileName(f), year(y), opened(false), file(f), size(0), mismatches(0) {}
+
+    // position of the file in the list being parsed, batches are committed
+    // in this order
+    int index;
+
+    QString fileName;
+    int year;
+
+    bool opened;
+
+    // the mapped file, the records refer into it.  It is held until the
+    // job is committed and deleted.
+    FileReader file;
+    qint64 size;
+
+    // digest of the file, taken by the worker for the manifest
+    QByteArray hash;
+
+    std::vector<FieldList> records;
+
+    ParseBatch batch;
+    unsigned int mismatches;
+};
+
+
+// The parse stage of the pipeline.  Takes tokenized jobs from one queue,
+// parses them into their batches and passes them on to the next.  Each
+// worker has its own parser, which keeps its own copy of the event table,
+// and every job is parsed in a context of its own.
+class ParseWorker : public QRunnable
+{
+public:
+    ParseWorker(const QString& dbPath,
+                Sabre::Output* out,
+                BoundedQueue<ParseJob*>& in,
+                BoundedQueue<ParseJob*>& parsed,
+                bool verifyEvents = false);
+
+    void run();
+
+    const StageStats& stats() const { return m_stats; }
+
+private:
+
+    QString m_dbPath;
+    Sabre::Output* m_output;
+
+    BoundedQueue<ParseJob*>& m_in;
+    BoundedQueue<ParseJob*>& m_parsed;
+
+    bool m_verifyEvents;
+
+    StageStats m_stats;
+};
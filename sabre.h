@@ -20,4 +20,5 @@
 #pragma once
 
 #include "sabre_search.h"
+#include "sabre_bench.h"
 #include "sabre_output.h"
@@ -0,0 +1,448 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#include "sabre_bench.h"
+#include "baseball.h"
+#include "parse_reader.h"
+#include "parse_scan.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QSettings>
+#include <QThread>
+#include <QThreadPool>
+
+#include <vector>
+
+namespace Sabre {
+
+    namespace {
+
+        typedef void (*benchFunc)(Output*);
+
+        struct Benchmark {
+            const char* name;
+            const char* description;
+            benchFunc pf;
+        };
+
+        static const Benchmark BENCHMARKS[] = {
+            { "lookup", "player lookups, hash index vs. ordered map", &benchLookup },
+            { "scan", "event file scanning, per character vs. vectorized", &benchScan },
+            { "stress", "concurrent record inserts and updates", &benchStress },
+            { "stats", "league totals, player years vs. stat columns", &benchStats },
+        };
+
+        static const int NUM_BENCHMARKS = sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]);
+
+        // number of operations each timed loop should run at least
+        static const unsigned int MIN_OPERATIONS = 2000000;
+
+        double perSecond(unsigned long long ops, qint64 nsecs)
+        {
+            return ((nsecs > 0) ? ((double)ops * 1000000000.0 / (double)nsecs) : 0.0);
+        }
+
+        // a record of the scratch table used by the stress benchmark.  Like
+        // a player it keeps a map of years, which writers add to.
+        class StressRecord : public Baseball::CoreRecord
+        {
+        public:
+            StressRecord(const Baseball::tag& t) : Baseball::CoreRecord(t) {}
+
+            std::map<int, unsigned int> years;
+        };
+
+        typedef Baseball::CoreTable<StressRecord> StressTable;
+
+        class StressWriter : public QRunnable
+        {
+        public:
+            StressWriter(const std::vector<Baseball::tag>& tags, unsigned int seed, unsigned int ops) :
+                m_tags(tags), m_seed(seed), m_ops(ops) {}
+
+            void run()
+            {
+                unsigned int x = m_seed;
+
+                for (unsigned int i = 0; i < m_ops; i++) {
+                    x = (x * 1103515245) + 12345;
+
+                    const Baseball::tag& t = m_tags[(x >> 8) % m_tags.size()];
+                    StressRecord* r = StressTable::createShared(t);
+
+                    QMutexLocker lock(StressTable::recordLock(t));
+
+                    r->years[1900 + ((x >> 4) % 100)]++;
+                }
+            }
+
+        private:
+            const std::vector<Baseball::tag>& m_tags;
+            unsigned int m_seed;
+            unsigned int m_ops;
+        };
+    }
+
+
+    void runBenchmark(Output* output, const QString& name)
+    {
+        for (int i = 0; i < NUM_BENCHMARKS; i++) {
+            if (name.compare(BENCHMARKS[i].name) == 0) {
+                BENCHMARKS[i].pf(output);
+                return;
+            }
+        }
+
+        output->log("Benchmarks:");
+
+        for (int i = 0; i < NUM_BENCHMARKS; i++) {
+            output->log("  %-10s %s", BENCHMARKS[i].name, BENCHMARKS[i].description);
+        }
+    }
+
+
+    void benchLookup(Output* output)
+    {
+        std::vector<Baseball::player_tag> tags;
+
+        Baseball::Player::Table::Reference r = Baseball::Player::Table::begin();
+
+        while (r != Baseball::Player::Table::end()) {
+            Baseball::player_tag t;
+
+            t.set(r.record()->id().ref, TAGLEN - 1);
+            tags.push_back(t);
+
+            r.next();
+        }
+
+        if (tags.empty()) {
+            output->log("The player table is empty, load a database first.");
+            return;
+        }
+
+        unsigned int rounds = (MIN_OPERATIONS / tags.size()) + 1;
+        unsigned long long ops = (unsigned long long)rounds * tags.size();
+        unsigned long long found = 0;
+        QElapsedTimer timer;
+        qint64 indexTime, mapTime;
+
+        timer.start();
+
+        for (unsigned int i = 0; i < rounds; i++) {
+            for (size_t j = 0; j < tags.size(); j++) {
+                if (Baseball::Player::Table::get(tags[j])) found++;
+            }
+        }
+
+        indexTime = timer.nsecsElapsed();
+
+        timer.restart();
+
+        for (unsigned int i = 0; i < rounds; i++) {
+            for (size_t j = 0; j < tags.size(); j++) {
+                if (Baseball::Player::Table::getOrdered(tags[j])) found++;
+            }
+        }
+
+        mapTime = timer.nsecsElapsed();
+
+        output->log("Lookup of %u players, %llu lookups each:",
+                    (unsigned int)tags.size(), ops);
+        output->log("  hash index   %12.0f lookups/s", perSecond(ops, indexTime));
+        output->log("  ordered map  %12.0f lookups/s", perSecond(ops, mapTime));
+
+        if (found != (ops * 2)) {
+            output->log("  %llu lookups failed", (ops * 2) - found);
+        }
+    }
+
+
+    void benchScan(Output* output)
+    {
+        QString path = QSettings().value("database/path").toString();
+
+        if (path.isEmpty()) {
+            output->log("No database is open.");
+            return;
+        }
+
+        QDir db(path);
+
+        // every event file of every season, read into memory up front
+        std::vector<QByteArray> files;
+        qint64 bytes = 0;
+
+        QStringList filters;
+        filters << "*.EVA" << "*.EVN";
+
+        QFileInfoList years = db.entryInfoList(QDir::AllDirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+
+        for (int i = 0; i < years.size(); i++) {
+            QDir d(years.at(i).absoluteFilePath());
+            QStringList names = d.entryList(filters, QDir::Files | QDir::NoSymLinks);
+
+            for (int j = 0; j < names.size(); j++) {
+                QFile f(d.absoluteFilePath(names.at(j)));
+
+                if (f.open(QIODevice::ReadOnly)) {
+                    files.push_back(f.readAll());
+                    bytes += files.back().size();
+                }
+            }
+        }
+
+        if (files.empty()) {
+            output->log("The database has no event files.");
+            return;
+        }
+
+        unsigned int rounds = static_cast<unsigned int>((MIN_OPERATIONS * 50) / bytes) + 1;
+        unsigned long long scalarCount = 0, scanCount = 0;
+        unsigned long long lineFields = 0, indexFields = 0;
+        std::vector<quint32> offsets;
+        std::vector<FieldList> records;
+        QElapsedTimer timer;
+        qint64 scalarTime, scanTime, lineTime, indexTime;
+
+        timer.start();
+
+        for (unsigned int r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < files.size(); i++) {
+                offsets.clear();
+                DelimiterScan::scanScalar(files[i].constData(), files[i].size(), offsets);
+                scalarCount += offsets.size();
+            }
+        }
+
+        scalarTime = timer.nsecsElapsed();
+
+        timer.restart();
+
+        for (unsigned int r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < files.size(); i++) {
+                offsets.clear();
+                DelimiterScan::scan(files[i].constData(), files[i].size(), offsets);
+                scanCount += offsets.size();
+            }
+        }
+
+        scanTime = timer.nsecsElapsed();
+
+        // splitting a line at a time, as the parser did before the scan
+        timer.restart();
+
+        for (unsigned int r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < files.size(); i++) {
+                const char* data = files[i].constData();
+                qint64 size = files[i].size();
+                qint64 pos = 0;
+                FieldList chunks;
+
+                while (pos < size) {
+                    chunks.split(FileReader::nextLine(data, size, pos));
+                    lineFields += chunks.size();
+                }
+            }
+        }
+
+        lineTime = timer.nsecsElapsed();
+
+        timer.restart();
+
+        for (unsigned int r = 0; r < rounds; r++) {
+            for (size_t i = 0; i < files.size(); i++) {
+                records.clear();
+                FieldList::splitLines(files[i].constData(), files[i].size(), records);
+
+                for (size_t j = 0; j < records.size(); j++) {
+                    indexFields += records[j].size();
+                }
+            }
+        }
+
+        indexTime = timer.nsecsElapsed();
+
+        unsigned long long total = (unsigned long long)bytes * rounds;
+        const double MB = 1024.0 * 1024.0;
+
+        output->log("Scan of %u event files, %.1f MB, %u rounds (%s):",
+                    (unsigned int)files.size(), (double)bytes / MB,
+                    rounds, DelimiterScan::instructionSet());
+        output->log("  scan, per character  %10.1f MB/s", perSecond(total, scalarTime) / MB);
+        output->log("  scan, vectorized     %10.1f MB/s", perSecond(total, scanTime) / MB);
+        output->log("  split, by line       %10.1f MB/s", perSecond(total, lineTime) / MB);
+        output->log("  split, by index      %10.1f MB/s", perSecond(total, indexTime) / MB);
+
+        if ((scalarCount != scanCount) || (lineFields != indexFields)) {
+            output->log("  the scans disagree: %llu/%llu delimiters, %llu/%llu fields",
+                        scalarCount, scanCount, lineFields, indexFields);
+        }
+    }
+
+
+    void benchStress(Output* output)
+    {
+        static const unsigned int NUM_TAGS = 20000;
+
+        std::vector<Baseball::tag> tags;
+        char sz[TAGLEN];
+
+        for (unsigned int i = 0; i < NUM_TAGS; i++) {
+            Baseball::tag t;
+
+            _snprintf(sz, TAGLEN, "stress%06u", i);
+            t.set(sz, strlen(sz));
+            tags.push_back(t);
+        }
+
+        int maxWriters = qMax(QThread::idealThreadCount(), 1) * 2;
+
+        output->log("Stress of %u records, %u updates a round:", NUM_TAGS, MIN_OPERATIONS);
+
+        for (int writers = 1; writers <= maxWriters; writers *= 2) {
+            QThreadPool pool;
+            QElapsedTimer timer;
+            unsigned int ops = MIN_OPERATIONS / writers;
+
+            pool.setMaxThreadCount(writers);
+            timer.start();
+
+            for (int i = 0; i < writers; i++) {
+                pool.start(new StressWriter(tags, 1 + i, ops));
+            }
+
+            pool.waitForDone();
+
+            qint64 writeTime = timer.nsecsElapsed();
+
+            // records put in the table while inserts were still pending are
+            // replaced by the pending ones when they are published
+            size_t added = 0;
+
+            for (size_t i = 0; i < tags.size(); i += 100) {
+                if (!StressTable::getShared(tags[i])) added++;
+
+                StressTable::createRecord(tags[i]);
+            }
+
+            size_t created = StressTable::publishShared();
+
+            // every update must have landed in exactly one record
+            unsigned long long total = 0;
+
+            for (size_t i = 0; i < tags.size(); i++) {
+                StressRecord* r = StressTable::get(tags[i]);
+
+                if (!r) continue;
+
+                std::map<int, unsigned int>::const_iterator it = r->years.begin();
+
+                for (; it != r->years.end(); it++) {
+                    total += it->second;
+                }
+            }
+
+            // lookups once the table is published take the plain path
+            unsigned long long found = 0;
+
+            timer.restart();
+
+            for (size_t i = 0; i < tags.size(); i++) {
+                if (StressTable::get(tags[i])) found++;
+            }
+
+            qint64 getTime = timer.nsecsElapsed();
+
+            output->log("  %2d writers  %12.0f updates/s  %12.0f lookups/s  %s",
+                        writers,
+                        perSecond((unsigned long long)ops * writers, writeTime),
+                        perSecond(tags.size(), getTime),
+                        ((total == (unsigned long long)ops * writers) &&
+                         (found == (created + added)) &&
+                         ((created + added) == StressTable::count())) ? "ok" : "LOST UPDATES");
+
+            for (size_t i = 0; i < tags.size(); i++) {
+                delete StressTable::remove(tags[i]);
+            }
+        }
+    }
+
+
+    void benchStats(Output* output)
+    {
+        Baseball::StatTable::build();
+
+        size_t seasons = Baseball::StatTable::count();
+
+        if (seasons == 0) {
+            output->log("The stat table is empty, load a database first.");
+            return;
+        }
+
+        unsigned int rounds = (MIN_OPERATIONS / seasons) + 1;
+        unsigned long long ops = (unsigned long long)rounds * seasons;
+        unsigned long long recordTotal = 0, columnTotal = 0;
+        QElapsedTimer timer;
+        qint64 recordTime, columnTime;
+
+        timer.start();
+
+        for (unsigned int i = 0; i < rounds; i++) {
+            Baseball::Player::Table::Reference r = Baseball::Player::Table::begin();
+
+            while (r != Baseball::Player::Table::end()) {
+                const Baseball::Player::Record::Years& years = r.record()->years();
+
+                // the same seasons the stat table holds, walked in place
+                for (size_t y = 0; y < years.size(); y++) {
+                    if (years[y].first.type != Baseball::Player::Record::TeamYear::TEAMYEAR) continue;
+
+                    recordTotal += years[y].second.batting.HR.value;
+                }
+
+                r.next();
+            }
+        }
+
+        recordTime = timer.nsecsElapsed();
+
+        Baseball::StatTable::Selection sel = Baseball::StatTable::all();
+
+        timer.restart();
+
+        for (unsigned int i = 0; i < rounds; i++) {
+            columnTotal += Baseball::StatTable::sum(sel, Baseball::Stat::BattingHR);
+        }
+
+        columnTime = timer.nsecsElapsed();
+
+        output->log("Home run totals over %u seasons, %u rounds:", (unsigned int)seasons, rounds);
+        output->log("  player years  %12.0f seasons/s", perSecond(ops, recordTime));
+        output->log("  stat column   %12.0f seasons/s", perSecond(ops, columnTime));
+        output->log("  league OBP %.3f SLG %.3f",
+                    Baseball::StatTable::obp(sel), Baseball::StatTable::slg(sel));
+
+        if (recordTotal != columnTotal) {
+            output->log("  the totals disagree: %llu/%llu", recordTotal, columnTotal);
+        }
+    }
+}
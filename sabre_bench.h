@@ -0,0 +1,48 @@
+/**
+ *
+ * Sabre - A sabermetrically designed database for baseball statistics
+ * Copyright (C) 2014  Stephen Schweizer (code@theindexzero.com)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+#pragma once
+
+#include <QString>
+
+#include "sabre_output.h"
+
+namespace Sabre {
+
+    // runs the named benchmark against the loaded tables and logs the
+    // results, or lists the benchmarks if name is not one of them
+    void runBenchmark(Output* output, const QString& name);
+
+    // times lookups of every player through the table's hash index and
+    // through its ordered map
+    void benchLookup(Output* output);
+
+    // times the delimiter scan and the splitting of lines into fields over
+    // the event files of the open database, a character at a time and
+    // vectorized
+    void benchScan(Output* output);
+
+    // has many threads create and update records of a scratch table through
+    // the shared insert path at once, and checks that nothing was lost
+    void benchStress(Output* output);
+
+    // times league totals of a statistic by walking every player's years
+    // and by summing the stat table's column
+    void benchStats(Output* output);
+}
@@ -21,48 +21,221 @@
 #include "baseball.h"
 
 #include <QStringList>
+#include <algorithm>
+#include <iterator>
 #include <sstream>
 
 namespace Sabre {
 
-    void searchPlayer(Output* output, const QString& search)
+    namespace {
+
+        // orders posting lists by length
+        struct ShorterPostings
+        {
+            bool operator()(const std::vector<unsigned int>* a,
+                            const std::vector<unsigned int>* b) const
+            {
+                return (a->size() < b->size());
+            }
+        };
+    }
+
+
+    NameIndex::NameIndex()
+        : m_built(false),
+          m_generation(0)
     {
-        QStringList sl = search.split(QRegExp("\\s+"));
+    }
+
+
+    NameIndex::Trigram NameIndex::trigram(const QChar* s)
+    {
+        return ((Trigram)s[0].unicode() << 32) |
+               ((Trigram)s[1].unicode() << 16) |
+                (Trigram)s[2].unicode();
+    }
+
+
+    bool NameIndex::matches(const Baseball::Player::Record* p, const QString& token)
+    {
+        QString ln(p->surName.c_str());
+
+        if (ln.contains(token, Qt::CaseInsensitive)) {
+            return true;
+        }
+
+        QString fn(p->firstName.c_str());
+
+        return fn.contains(token, Qt::CaseInsensitive);
+    }
+
+
+    void NameIndex::build()
+    {
+        NameIndex* ni = getInstance();
+
+        ni->m_players.clear();
+        ni->m_postings.clear();
 
         Baseball::Player::Table::Reference r = Baseball::Player::Table::begin();
-        Baseball::Player::Table::RecordList rl;
 
         while (r != Baseball::Player::Table::end()) {
             Baseball::Player::Record* p = r.record();
-            bool matched = false;
 
             if (p) {
-                QString ln(p->surName.c_str());
+                unsigned int n = (unsigned int)ni->m_players.size();
 
-                for (int j = 0; j < sl.size(); j++) {
-                    if (ln.contains(sl.at(j), Qt::CaseInsensitive)) {
-                        rl.push_back(p);
-                        matched = true;
-                        break;
-                    }
-                }
+                ni->m_players.push_back(p);
+
+                ni->addName(p->surName, n);
+                ni->addName(p->firstName, n);
+            }
+
+            r.next();
+        }
+
+        ni->m_built = true;
+        ni->m_generation = Baseball::Player::Table::generation();
+    }
+
+
+    bool NameIndex::isCurrent()
+    {
+        NameIndex* ni = getInstance();
 
+        return (ni->m_built && (ni->m_generation == Baseball::Player::Table::generation()));
+    }
+
+
+    void NameIndex::addName(const std::string& name, unsigned int player)
+    {
+        QString s(name.c_str());
+        std::vector<QChar> folded(s.size());
+
+        // fold each code unit the way Qt's case insensitive compare does
+        for (int i = 0; i < s.size(); i++) {
+            folded[i] = s.at(i).toCaseFolded();
+        }
 
-                if (!matched) {
-                    QString fn(p->firstName.c_str());
+        for (size_t i = 0; i + 3 <= folded.size(); i++) {
+            Postings& pl = m_postings[trigram(&folded[i])];
 
-                    for (int i = 0; i < sl.size(); i++) {
-                        if (fn.contains(sl.at(i), Qt::CaseInsensitive)) {
-                            rl.push_back(p);
-                            break;
-                        }
+            // players are added in order, so a repeat is always at the back
+            if (pl.empty() || pl.back() != player) {
+                pl.push_back(player);
+            }
+        }
+    }
+
+
+    bool NameIndex::candidates(const QString& token, Postings& out) const
+    {
+        if (token.size() < 3) {
+            return false;
+        }
+
+        std::vector<QChar> folded(token.size());
+
+        for (int i = 0; i < token.size(); i++) {
+            // surrogate pairs fold as a unit; leave those to a scan
+            if (token.at(i).isSurrogate()) {
+                return false;
+            }
+
+            folded[i] = token.at(i).toCaseFolded();
+        }
+
+        std::vector<const Postings*> lists;
+
+        out.clear();
+
+        for (size_t i = 0; i + 3 <= folded.size(); i++) {
+            std::map<Trigram, Postings>::const_iterator it =
+                m_postings.find(trigram(&folded[i]));
+
+            if (it == m_postings.end()) {
+                return true;
+            }
+
+            lists.push_back(&it->second);
+        }
+
+        // intersect starting from the shortest list
+        std::sort(lists.begin(), lists.end(), ShorterPostings());
+
+        out = *lists[0];
+
+        Postings merged;
+
+        for (size_t i = 1; i < lists.size() && !out.empty(); i++) {
+            merged.clear();
+
+            std::set_intersection(out.begin(), out.end(),
+                                  lists[i]->begin(), lists[i]->end(),
+                                  std::back_inserter(merged));
+            out.swap(merged);
+        }
+
+        return true;
+    }
+
+
+    Baseball::Player::Table::RecordList NameIndex::search(const QStringList& tokens)
+    {
+        if (!isCurrent()) {
+            build();
+        }
+
+        const NameIndex* ni = getInstance();
+        const std::vector<Baseball::Player::Record*>& players = ni->m_players;
+        std::vector<unsigned char> hit(players.size(), 0);
+        Postings cand;
+
+        for (int j = 0; j < tokens.size(); j++) {
+            const QString& token = tokens.at(j);
+
+            if (ni->candidates(token, cand)) {
+                for (size_t i = 0; i < cand.size(); i++) {
+                    unsigned int n = cand[i];
+
+                    if (!hit[n] && matches(players[n], token)) {
+                        hit[n] = 1;
+                    }
+                }
+            } else {
+                // too short to index, scan everyone
+                for (size_t n = 0; n < players.size(); n++) {
+                    if (!hit[n] && matches(players[n], token)) {
+                        hit[n] = 1;
                     }
                 }
             }
+        }
 
-            r.next();
+        Baseball::Player::Table::RecordList rl;
+
+        for (size_t n = 0; n < players.size(); n++) {
+            if (hit[n]) {
+                rl.push_back(players[n]);
+            }
         }
 
+        return rl;
+    }
+
+
+    void buildSearchIndex()
+    {
+        NameIndex::build();
+    }
+
+
+    void searchPlayer(Output* output, const QString& search)
+    {
+        QStringList sl = search.split(QRegExp("\\s+"));
+
+        Baseball::Player::Table::RecordList rl = NameIndex::search(sl);
+
         Baseball::Player::Table::RecordList::iterator it;
         std::ostringstream oss;
 
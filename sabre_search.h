@@ -20,10 +20,58 @@
 #pragma once
 
 #include <QString>
+#include <QStringList>
+
+#include <map>
+#include <vector>
 
 #include "sabre_output.h"
+#include "bb_player.h"
 
 namespace Sabre {
 
+    // An inverted index from the trigrams of player names to the players
+    // carrying them.  Trigrams are taken over case folded names so a case
+    // insensitive substring match of three or more characters can be found
+    // by intersecting posting lists; every candidate is still verified with
+    // QString::contains so results match a full scan exactly.  The index
+    // holds record pointers, so it is rebuilt once the player table has
+    // deleted records.
+    class NameIndex : public Baseball::Singleton<NameIndex>
+    {
+    public:
+        NameIndex();
+
+        // (re)builds the index from the current player table
+        static void build();
+
+        // true if the index was built and no player has been deleted since
+        static bool isCurrent();
+
+        // returns the players whose surname or first name contains any of the
+        // given tokens, in table order.  A stale index is rebuilt first.
+        static Baseball::Player::Table::RecordList search(const QStringList& tokens);
+
+    private:
+        typedef std::vector<unsigned int> Postings;
+        typedef unsigned long long Trigram;
+
+        static Trigram trigram(const QChar* s);
+        static bool matches(const Baseball::Player::Record* p, const QString& token);
+
+        void addName(const std::string& name, unsigned int player);
+        bool candidates(const QString& token, Postings& out) const;
+
+        std::vector<Baseball::Player::Record*> m_players;
+        std::map<Trigram, Postings> m_postings;
+        bool m_built;
+
+        // Player::Table::generation when the index was built
+        unsigned int m_generation;
+    };
+
+    // rebuilds the player name index; call after the player table changes
+    void buildSearchIndex();
+
     void searchPlayer(Output* output, const QString& search);
 }
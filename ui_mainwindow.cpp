@@ -20,6 +20,7 @@
 #include "ui_mainwindow.h"
 #include "ui_databasedlg.h"
 #include "parse.h"
+#include "parse_loader.h"
 
 #include "baseball.h"
 #include "sabre.h"
@@ -101,29 +102,106 @@ void MainWindow::onChangeDataDirectory()
             Parser *p = new Parser(path, m_output);
 
             p->restrictYears(dbdlg.getSelectedYears());
+            p->setWorkerCount(QThread::idealThreadCount());
+
+            QSettings settings;
+            p->setVerifyEvents(settings.value("parser/verifyEvents", false).toBool());
+            p->setLazyGames(settings.value("parser/lazyGames", false).toBool());
+            settings.setValue("database/path", path);
+
+            openGameCache(path);
 
             activateWindow();
             raise();
 
-            p->moveToThread(&m_thread);
+            startParser(p, ParseTask);
+        }
+    }
+}
 
-            connect(&m_thread, SIGNAL(finished()), p, SLOT(deleteLater()));
-            connect(p, SIGNAL(finished()), this, SLOT(onParseFinished()));
-            connect(this, SIGNAL(parse()), p, SLOT(parse()));
 
-            m_thread.start();
+void MainWindow::startParser(Parser* p, ParserTask task)
+{
+    p->moveToThread(&m_thread);
+
+    connect(&m_thread, SIGNAL(finished()), p, SLOT(deleteLater()));
+    connect(p, SIGNAL(finished()), this, SLOT(onParseFinished()));
+
+    switch (task) {
+    case ParseTask:
+        connect(this, SIGNAL(parse()), p, SLOT(parse()));
+        break;
+    case LoadTask:
+        connect(this, SIGNAL(load()), p, SLOT(load()));
+        break;
+    case RefreshTask:
+        connect(this, SIGNAL(refresh()), p, SLOT(refresh()));
+        break;
+    }
 
-            emit parse();
-        }
+    m_thread.start();
+
+    switch (task) {
+    case ParseTask:
+        emit parse();
+        break;
+    case LoadTask:
+        emit load();
+        break;
+    case RefreshTask:
+        emit refresh();
+        break;
     }
 }
 
 
+void MainWindow::refreshDatabase()
+{
+    QSettings settings;
+    QString path = settings.value("database/path").toString();
+
+    if (path.isEmpty()) {
+        m_output->log(tr("No database is open."));
+        return;
+    }
+
+    if (m_thread.isRunning()) {
+        m_output->log(tr("The database is still being read."));
+        return;
+    }
+
+    Parser *p = new Parser(path, m_output);
+
+    p->setWorkerCount(QThread::idealThreadCount());
+    p->setVerifyEvents(settings.value("parser/verifyEvents", false).toBool());
+    p->setLazyGames(settings.value("parser/lazyGames", false).toBool());
+
+    startParser(p, RefreshTask);
+}
+
+
+void MainWindow::openGameCache(const QString& path)
+{
+    QSettings settings;
+
+    Baseball::Game::Cache::clear();
+    Baseball::Game::Cache::setLoader(new GameLoader(path, m_output));
+    Baseball::Game::Cache::setCapacity(
+        settings.value("games/cacheSize", (int)Baseball::Game::Cache::DEFAULT_CAPACITY).toInt());
+}
+
+
 void MainWindow::onParseFinished()
 {
     m_thread.quit();
     m_thread.wait();
 
+    Baseball::PlayTable::build();
+    Baseball::StatTable::build();
+    Sabre::buildSearchIndex();
+
+    m_output->log(tr("Loaded %1 play(s).").arg((unsigned long)Baseball::PlayTable::count()));
+
 #if 0
     Baseball::Player::Record* r =
         Baseball::Player::Table::get("bondb001");   // barry bonds
@@ -182,11 +260,38 @@ void MainWindow::onInput()
 
                 }
             }
+        } else if (l.at(0).compare("game") == 0) {
+            Baseball::Game::Record* r = Baseball::Game::Table::get(l.at(1).toStdString());
+
+            if (r) {
+                // the last state of a game holds no play
+                Baseball::StateLink st = Baseball::Game::Cache::plays(r);
+                unsigned int plays = 0;
+
+                while ((st) && (st->gameLink)) {
+                    st = st->gameLink;
+                    plays++;
+                }
+
+                m_output->log(tr("Game %1: %2 at %3, %4-%5, %6 play(s).")
+                              .arg(r->id().toString().c_str())
+                              .arg(r->teamVisiting.toString().c_str())
+                              .arg(r->teamHome.toString().c_str())
+                              .arg(r->runsVisited)
+                              .arg(r->runsHome)
+                              .arg(plays));
+            } else {
+                m_output->log(tr("Record `%1' was not found.").arg(l.at(1)));
+            }
         } else if (l.at(0).compare("search") == 0) {
             l.pop_front();
 
             Sabre::searchPlayer(m_output, l.join(QChar(' ')));
+        } else if (l.at(0).compare("bench") == 0) {
+            Sabre::runBenchmark(m_output, l.at(1));
         }
+    } else if (l.at(0).compare("refresh") == 0) {
+        refreshDatabase();
     }
 
     m_input->clear();
@@ -207,6 +312,20 @@ void MainWindow::restoreSettings()
     QSettings settings;
     restoreGeometry(settings.value("geometry").toByteArray());
     restoreState(settings.value("windowState").toByteArray());
+
+    // reopen the last database from its snapshot, if one was written
+    QString path = settings.value("database/path").toString();
+
+    if (!path.isEmpty()) {
+        Parser *p = new Parser(path, m_output);
+
+        if (QFile::exists(p->snapshotPath())) {
+            openGameCache(path);
+            startParser(p, LoadTask);
+        } else {
+            delete p;
+        }
+    }
 }
 
 
@@ -54,12 +54,30 @@ protected slots:
 signals:
 
     void parse();
+    void load();
+    void refresh();
 
 protected:
 
     void saveSettings();
     void restoreSettings();
 
+    enum ParserTask {
+        ParseTask,
+        LoadTask,
+        RefreshTask
+    };
+
+    // runs the parser on the parser thread, either parsing the database,
+    // loading its snapshot, or refreshing it from the changed files
+    void startParser(Parser* p, ParserTask task);
+
+    // re-parses the changed files of the open database
+    void refreshDatabase();
+
+    // sets up loading of lazily parsed games from the database at path
+    void openGameCache(const QString& path);
+
 protected:
     Sabre::Output* m_output;
 